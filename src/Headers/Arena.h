@@ -0,0 +1,160 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "MemoryStats.h"
+#include "Parallel.h"
+
+#define ARENA_CHUNK_BYTES (1 << 20)
+
+/// \file
+/// Arenas for the point buffers of shapes. A render takes its points from an arena instead of growing a
+/// vector per shape, and resets the arena once the points are uploaded or written out, so the next render
+/// reuses the same chunks without touching the heap.
+
+/// <summary>
+/// Contiguous run of count elements owned by an Arena. Stays valid until the arena is reset.
+/// </summary>
+template <typename T>
+struct slice
+{
+	T* data;
+	size_t count;
+};
+
+/// <summary>
+/// Bump allocator for the point buffers of a frame or scene. Every lane owns a list of chunks and hands
+/// out memory by moving a cursor through them, so allocating is a few additions and never takes a lock
+/// as long as each thread uses its own lane (e.g. the worker index passed by parallel_for_chunks).
+/// Chunks are kept when the arena is reset and reused by the next frame.
+/// </summary>
+class Arena
+{
+public:
+	/// <param name="lanes"> Number of threads that may allocate at the same time</param>
+	/// <param name="chunk_bytes"> Size of a chunk; larger requests get a chunk of their own size</param>
+	explicit Arena(long lanes = parallel_worker_count(), size_t chunk_bytes = ARENA_CHUNK_BYTES)
+		: chunk_bytes(chunk_bytes), generation(0), lanes(lanes), chunk_memory(&memory_stage_get(MEMORY_STAGE_ARENA))
+	{
+	}
+
+	~Arena()
+	{
+		for (size_t l = 0; l < lanes.size(); l++)
+		{
+			for (size_t c = 0; c < lanes[l].chunks.size(); c++)
+			{
+				memory_freed(*chunk_memory, lanes[l].chunks[c].size);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Uninitialized room for count elements of T from the given lane.
+	/// </summary>
+	template <typename T>
+	struct slice<T> allocate(size_t count, long lane = 0)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "Arena never runs destructors");
+		assert((lane >= 0) && (lane < (long)lanes.size()));
+
+		struct arena_lane& current = lanes[lane];
+		if (current.generation != generation)
+		{
+			// First allocation since a reset: start over from the first chunk.
+			current.generation = generation;
+			current.chunk = 0;
+			current.used = 0;
+		}
+
+		size_t bytes = count * sizeof(T);
+		size_t offset = (current.used + alignof(T) - 1) & ~(alignof(T) - 1);
+		while ((current.chunk >= current.chunks.size()) || ((offset + bytes) > current.chunks[current.chunk].size))
+		{
+			if ((current.chunk < current.chunks.size()) && (current.used > 0))
+			{
+				current.chunk = current.chunk + 1;
+			}
+			else if (current.chunk < current.chunks.size())
+			{
+				// Even an empty chunk is too small for this request; replace it by one that fits.
+				memory_freed(*chunk_memory, current.chunks[current.chunk].size);
+				current.chunks[current.chunk] = arena_chunk_create(std::max(chunk_bytes, bytes));
+			}
+			else
+			{
+				current.chunks.push_back(arena_chunk_create(std::max(chunk_bytes, bytes)));
+			}
+			current.used = 0;
+			offset = 0;
+		}
+
+		current.used = offset + bytes;
+		struct slice<T> result = { reinterpret_cast<T*>(current.chunks[current.chunk].memory.get() + offset), count };
+		return result;
+	}
+
+	/// <summary>
+	/// Releases every slice handed out so far, in O(1): lanes rewind to their first chunk on their next allocation.
+	/// No lane may be allocating while the arena is reset.
+	/// </summary>
+	void reset()
+	{
+		generation = generation + 1;
+	}
+
+	long lane_count() const
+	{
+		return lanes.size();
+	}
+
+private:
+	struct arena_chunk
+	{
+		std::unique_ptr<char[]> memory;
+		size_t size;
+	};
+
+	struct arena_lane
+	{
+		std::vector<struct arena_chunk> chunks;
+		size_t chunk = 0;
+		size_t used = 0;
+		unsigned long generation = 0;
+	};
+
+	struct arena_chunk arena_chunk_create(size_t size)
+	{
+		struct arena_chunk chunk = { std::unique_ptr<char[]>(new char[size]), size };
+		memory_allocated(*chunk_memory, size);
+		return chunk;
+	}
+
+	size_t chunk_bytes;
+	unsigned long generation;
+	std::vector<struct arena_lane> lanes;
+	// Looked up on construction, so that the registry outlives a static arena.
+	struct memory_stage* chunk_memory;
+};
+
+/// <summary>
+/// Arena shared by the shapes of the current scene. Reset it once the scene has been uploaded. Shapes computed
+/// at the same time have to use different lanes.
+/// </summary>
+inline Arena& scene_arena()
+{
+	static Arena arena;
+	return arena;
+}
+
+/// <summary>
+/// parallel_shade() over the interleaved (x, y, r, g, b) vertices of a slice of 5 * n floats.
+/// </summary>
+template <typename Shade>
+void parallel_shade(struct slice<float> vertices, Shade shade)
+{
+	parallel_shade<5, 5>(vertices.data, vertices.data + 2, vertices.count / 5, shade);
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "Rasterizer.h"
+
+#define ARROWHEAD_REACH 3
+#define ARROWHEAD_STAMP_POINTS (2 * ARROWHEAD_REACH + 1)
+
+/// \file
+/// Arrowheads of the vector field programs. The strokes are 3 * unit vector long, so their direction only
+/// takes the values (delta_x, delta_y) in [-ARROWHEAD_REACH, ARROWHEAD_REACH]. Both strokes for every such
+/// pair are rasterized once at compile time, and the programs stamp the matching offsets at the tip of each
+/// arrow instead of rasterizing the strokes again.
+
+/// <summary>
+/// (x, y) offsets of both strokes of one arrowhead, relative to the tip.
+/// </summary>
+struct arrowhead_stamp
+{
+	int count;
+	int offsets[2 * 2 * ARROWHEAD_STAMP_POINTS];
+};
+
+struct arrowhead_table
+{
+	struct arrowhead_stamp stamp[2 * ARROWHEAD_REACH + 1][2 * ARROWHEAD_REACH + 1];
+};
+
+/// <summary>
+/// Appends the stroke from the origin of the stamp to (x_final, y_final), rasterized by rasterize_line.
+/// </summary>
+constexpr void arrowhead_stroke(struct arrowhead_stamp& stamp, int x_final, int y_final)
+{
+	int delta_x = (x_final >= 0) ? x_final : -x_final;
+	int delta_y = (y_final >= 0) ? y_final : -y_final;
+	int major = (delta_x > delta_y) ? delta_x : delta_y;
+	struct strided_sink<2, int> sink = { stamp.offsets + (2 * stamp.count) };
+	rasterize_line(sink, 0, 0, x_final, y_final, 0, major);
+	stamp.count = stamp.count + major + 1;
+}
+
+constexpr struct arrowhead_table arrowhead_table_build()
+{
+	struct arrowhead_table table{};
+	for (int delta_x = -ARROWHEAD_REACH; delta_x <= ARROWHEAD_REACH; delta_x++)
+	{
+		for (int delta_y = -ARROWHEAD_REACH; delta_y <= ARROWHEAD_REACH; delta_y++)
+		{
+			struct arrowhead_stamp& stamp = table.stamp[delta_x + ARROWHEAD_REACH][delta_y + ARROWHEAD_REACH];
+			arrowhead_stroke(stamp, -delta_x - delta_y, delta_x - delta_y);
+			arrowhead_stroke(stamp, -delta_x + delta_y, -delta_x - delta_y);
+		}
+	}
+	return table;
+}
+
+constexpr struct arrowhead_table arrowhead_stamps = arrowhead_table_build();
+
+/// <summary>
+/// trunc(ARROWHEAD_REACH * component / |vector|) without sqrt or division, by comparing squares.
+/// The squares are taken in double, so any long component works. A (0, 0) vector has no direction and gives 0,
+/// which makes its arrowhead the single pixel at the tip.
+/// </summary>
+/// <param name="component"> Component of the vector to quantize</param>
+/// <param name="other"> The other component of the vector</param>
+inline long arrowhead_quantize(long component, long other)
+{
+	double squared = (double)component * (double)component;
+	double total = squared + ((double)other * (double)other);
+	long reach = (total > 0) ? ARROWHEAD_REACH : 0;
+	while ((reach > 0) && ((ARROWHEAD_REACH * ARROWHEAD_REACH) * squared < (double)(reach * reach) * total))
+	{
+		reach = reach - 1;
+	}
+	return (component < 0) ? -reach : reach;
+}
+
+/// <summary>
+/// Stamp of the arrowhead for an arrow along (x_vector, y_vector).
+/// </summary>
+inline const struct arrowhead_stamp& arrowhead_stamp_for(long x_vector, long y_vector)
+{
+	long delta_x = arrowhead_quantize(x_vector, y_vector);
+	long delta_y = arrowhead_quantize(y_vector, x_vector);
+	return arrowhead_stamps.stamp[delta_x + ARROWHEAD_REACH][delta_y + ARROWHEAD_REACH];
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+
+#define OUTCODE_INSIDE 0
+#define OUTCODE_LEFT 1
+#define OUTCODE_RIGHT 2
+#define OUTCODE_BOTTOM 4
+#define OUTCODE_TOP 8
+
+#define CLIP_OUTSIDE 0
+#define CLIP_INSIDE 1
+#define CLIP_PARTIAL 2
+
+/// \file
+
+/// <summary>
+/// Visible pixel range, inclusive on all four sides.
+/// </summary>
+struct viewport
+{
+	long x_min;
+	long y_min;
+	long x_max;
+	long y_max;
+};
+
+/// <summary>
+/// Cohen-Sutherland region code of a pixel relative to the viewport.
+/// </summary>
+inline int compute_outcode(const struct viewport& view, long x, long y)
+{
+	int outcode = OUTCODE_INSIDE;
+	if (x < view.x_min)
+	{
+		outcode = outcode | OUTCODE_LEFT;
+	}
+	else if (x > view.x_max)
+	{
+		outcode = outcode | OUTCODE_RIGHT;
+	}
+	if (y < view.y_min)
+	{
+		outcode = outcode | OUTCODE_BOTTOM;
+	}
+	else if (y > view.y_max)
+	{
+		outcode = outcode | OUTCODE_TOP;
+	}
+	return outcode;
+}
+
+constexpr bool inside_viewport(const struct viewport& view, long x, long y)
+{
+	return (x >= view.x_min) && (x <= view.x_max) && (y >= view.y_min) && (y <= view.y_max);
+}
+
+/// <summary>
+/// Minor axis offset of the Bresenham pixel after the given number of major axis steps.
+/// </summary>
+/// <param name="major"> Length of the line along its major axis</param>
+/// <param name="minor"> Length of the line along its minor axis</param>
+/// <param name="step"> Number of steps taken along the major axis</param>
+constexpr long bresenham_minor_offset(long major, long minor, long step)
+{
+	if (major == 0)
+	{
+		return 0;
+	}
+	return ((2 * minor * step) + major) / (2 * major);
+}
+
+/// <summary>
+/// Decision variable of the Bresenham loop after the given number of major axis steps, i.e. the value
+/// the serial loop holds right before it takes step + 1.
+/// </summary>
+constexpr long bresenham_decision(long major, long minor, long step)
+{
+	return (2 * minor * (step + 1)) - major - (2 * major * bresenham_minor_offset(major, minor, step));
+}
+
+/// <summary>
+/// Smallest step whose minor axis offset is at least the given value.
+/// </summary>
+inline long bresenham_first_step_reaching(long major, long minor, long offset)
+{
+	if (offset <= 0)
+	{
+		return 0;
+	}
+	long numerator = (2 * major * offset) - major;
+	return (numerator + (2 * minor) - 1) / (2 * minor);
+}
+
+/// <summary>
+/// Clips the Bresenham line from (x_initial, y_initial) to (x_final, y_final) against the viewport.
+/// Endpoint outcodes are used to trivially accept or reject the line. Otherwise the visible range is
+/// intersected in step space, so that the clipped line keeps exactly the pixels of the unclipped one.
+/// </summary>
+/// <param name="first"> First visible step along the major axis</param>
+/// <param name="last"> Last visible step along the major axis</param>
+/// <returns> true if at least one pixel of the line is visible</returns>
+inline bool clip_line_steps(const struct viewport& view, long x_initial, long y_initial, long x_final, long y_final,
+	long& first, long& last)
+{
+	long delta_x = ((x_final - x_initial) >= 0) ? (x_final - x_initial) : -(x_final - x_initial);
+	long delta_y = ((y_final - y_initial) >= 0) ? (y_final - y_initial) : -(y_final - y_initial);
+	bool x_major = delta_x > delta_y;
+	long major = x_major ? delta_x : delta_y;
+	long minor = x_major ? delta_y : delta_x;
+
+	int outcode_initial = compute_outcode(view, x_initial, y_initial);
+	int outcode_final = compute_outcode(view, x_final, y_final);
+	first = 0;
+	last = major;
+	if ((outcode_initial | outcode_final) == OUTCODE_INSIDE)
+	{
+		return true;
+	}
+	if ((outcode_initial & outcode_final) != OUTCODE_INSIDE)
+	{
+		return false;
+	}
+
+	long major_initial = x_major ? x_initial : y_initial;
+	long minor_initial = x_major ? y_initial : x_initial;
+	long major_final = x_major ? x_final : y_final;
+	long minor_final = x_major ? y_final : x_final;
+	long major_min = x_major ? view.x_min : view.y_min;
+	long major_max = x_major ? view.x_max : view.y_max;
+	long minor_min = x_major ? view.y_min : view.x_min;
+	long minor_max = x_major ? view.y_max : view.x_max;
+
+	// The major coordinate moves by one every step.
+	if (major_final >= major_initial)
+	{
+		first = std::max(first, major_min - major_initial);
+		last = std::min(last, major_max - major_initial);
+	}
+	else
+	{
+		first = std::max(first, major_initial - major_max);
+		last = std::min(last, major_initial - major_min);
+	}
+
+	// The minor coordinate moves monotonically, so its visible range maps to a contiguous range of steps.
+	long offset_low = (minor_final >= minor_initial) ? (minor_min - minor_initial) : (minor_initial - minor_max);
+	long offset_high = (minor_final >= minor_initial) ? (minor_max - minor_initial) : (minor_initial - minor_min);
+	if ((offset_high < 0) || (offset_low > minor))
+	{
+		return false;
+	}
+	if (minor > 0)
+	{
+		first = std::max(first, bresenham_first_step_reaching(major, minor, offset_low));
+		last = std::min(last, bresenham_first_step_reaching(major, minor, offset_high + 1) - 1);
+	}
+
+	return first <= last;
+}
+
+/// <summary>
+/// Classifies a circle against the viewport using its bounding box.
+/// </summary>
+/// <returns> CLIP_OUTSIDE, CLIP_INSIDE or CLIP_PARTIAL</returns>
+inline int clip_circle(const struct viewport& view, long x_center, long y_center, long radius)
+{
+	long extent = (radius >= 0) ? radius : -radius;
+	int outcode_low = compute_outcode(view, x_center - extent, y_center - extent);
+	int outcode_high = compute_outcode(view, x_center + extent, y_center + extent);
+	if ((outcode_low | outcode_high) == OUTCODE_INSIDE)
+	{
+		return CLIP_INSIDE;
+	}
+	if ((outcode_low & outcode_high) != OUTCODE_INSIDE)
+	{
+		return CLIP_OUTSIDE;
+	}
+	return CLIP_PARTIAL;
+}
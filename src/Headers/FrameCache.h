@@ -0,0 +1,170 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "MemoryStats.h"
+
+/// \file
+/// Offscreen copy of a finished plot. The points are drawn into a texture once, and every later frame
+/// draws that texture on a single full-screen quad, so the cost of a frame no longer depends on the
+/// number of points.
+
+/// <summary>
+/// Framebuffer and color texture the plot is drawn into, and the program and vertex array that draw the
+/// texture back as a full-screen quad.
+/// </summary>
+struct frame_cache
+{
+	unsigned int framebuffer;
+	unsigned int texture;
+	unsigned int quad_array;
+	unsigned int quad_program;
+	int width;
+	int height;
+};
+
+inline unsigned int frame_cache_shader(unsigned int shader_type, const char* source_code)
+{
+	unsigned int shader_id = glCreateShader(shader_type);
+	glShaderSource(shader_id, 1, &source_code, NULL);
+	glCompileShader(shader_id);
+
+	int compilation_result;
+	glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compilation_result);
+	if (compilation_result == GL_FALSE)
+	{
+		char log_message[1024];
+		glGetShaderInfoLog(shader_id, sizeof(log_message), NULL, log_message);
+		std::cerr << "ERROR: Frame cache shader compilation failed.\n" << log_message << "\n";
+		glDeleteShader(shader_id);
+		return 0;
+	}
+	return shader_id;
+}
+
+/// <summary>
+/// Releases the GL objects of the cache, e.g. before creating it again at a new size.
+/// </summary>
+inline void frame_cache_destroy(struct frame_cache& cache)
+{
+	glDeleteVertexArrays(1, &cache.quad_array);
+	glDeleteProgram(cache.quad_program);
+	glDeleteFramebuffers(1, &cache.framebuffer);
+	glDeleteTextures(1, &cache.texture);
+	memory_freed(memory_stage_get(MEMORY_STAGE_GL_TEXTURES), (size_t)cache.width * cache.height * 4);
+}
+
+/// <summary>
+/// Creates the texture and framebuffer for a width x height plot, and the quad program.
+/// </summary>
+/// <returns> true on success\n false if the framebuffer is incomplete or the program cannot be built, in which case nothing is left allocated and the caller should keep drawing the points directly</returns>
+inline bool frame_cache_create(struct frame_cache& cache, int width, int height)
+{
+	// The quad needs no vertex buffer: the corners are derived from gl_VertexID, drawn as a 4 vertex strip.
+	const char* vertex_shader_source = "#version 330 core\n\nout vec2 texture_coordinate;\nvoid main()\n{\n\tvec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n\ttexture_coordinate = corner;\n\tgl_Position = vec4((2.0 * corner) - 1.0, 0.0, 1.0);\n}";
+	const char* fragment_shader_source = "#version 330 core\n\nin vec2 texture_coordinate;\nuniform sampler2D image;\nout vec4 color;\nvoid main()\n{\n\tcolor = texture(image, texture_coordinate);\n}";
+
+	// Everything is released again on failure, so the caller has nothing to destroy.
+	cache.width = width;
+	cache.height = height;
+	cache.framebuffer = 0;
+	cache.quad_array = 0;
+	cache.quad_program = 0;
+	glGenTextures(1, &cache.texture);
+	glBindTexture(GL_TEXTURE_2D, cache.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	memory_gl_allocated(MEMORY_STAGE_GL_TEXTURES, (size_t)width * height * 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &cache.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, cache.framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cache.texture, 0);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (!complete)
+	{
+		std::cerr << "ERROR: Frame cache framebuffer is incomplete. Drawing the points every frame instead.\n";
+		frame_cache_destroy(cache);
+		return false;
+	}
+
+	unsigned int vertex_shader_id = frame_cache_shader(GL_VERTEX_SHADER, vertex_shader_source);
+	unsigned int fragment_shader_id = frame_cache_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+	if ((vertex_shader_id == 0) || (fragment_shader_id == 0))
+	{
+		std::cerr << "ERROR: Frame cache shaders failed to compile. Drawing the points every frame instead.\n";
+		glDeleteShader(vertex_shader_id);
+		glDeleteShader(fragment_shader_id);
+		frame_cache_destroy(cache);
+		return false;
+	}
+	cache.quad_program = glCreateProgram();
+	glAttachShader(cache.quad_program, vertex_shader_id);
+	glAttachShader(cache.quad_program, fragment_shader_id);
+	glLinkProgram(cache.quad_program);
+	glDeleteShader(vertex_shader_id);
+	glDeleteShader(fragment_shader_id);
+
+	int link_result;
+	glGetProgramiv(cache.quad_program, GL_LINK_STATUS, &link_result);
+	if (link_result == GL_FALSE)
+	{
+		std::cerr << "ERROR: Frame cache program failed to link. Drawing the points every frame instead.\n";
+		frame_cache_destroy(cache);
+		return false;
+	}
+
+	// A vertex array of its own, so that the attribute setup of the points is left untouched.
+	glGenVertexArrays(1, &cache.quad_array);
+	return true;
+}
+
+/// <summary>
+/// Redirects drawing into the cache. Everything drawn until frame_cache_end() ends up in the texture.
+/// </summary>
+/// <param name="clear"> false keeps the previous image, so that only the primitives drawn next are replaced</param>
+inline void frame_cache_begin(const struct frame_cache& cache, bool clear = true)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, cache.framebuffer);
+	glViewport(0, 0, cache.width, cache.height);
+	if (clear)
+	{
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+}
+
+/// <summary>
+/// Restores drawing to the window, whose framebuffer is window_width x window_height.
+/// </summary>
+inline void frame_cache_end(int window_width, int window_height)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, window_width, window_height);
+}
+
+/// <summary>
+/// Draws the cached plot over the whole window with a single quad. The program and vertex array in use
+/// before the call are restored afterwards.
+/// </summary>
+inline void frame_cache_draw(const struct frame_cache& cache)
+{
+	int program_id;
+	int vertex_array;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program_id);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertex_array);
+
+	glUseProgram(cache.quad_program);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, cache.texture);
+	glUniform1i(glGetUniformLocation(cache.quad_program, "image"), 0);
+	glBindVertexArray(cache.quad_array);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	glBindVertexArray(vertex_array);
+	glUseProgram(program_id);
+}
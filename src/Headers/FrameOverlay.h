@@ -0,0 +1,240 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "FrameCache.h"
+#include "FrameStats.h"
+
+#define FRAME_OVERLAY_SCALE 3
+#define FRAME_OVERLAY_MARGIN 8
+#define FRAME_OVERLAY_GLYPH_WIDTH 3
+#define FRAME_OVERLAY_GLYPH_HEIGHT 5
+
+/// \file
+/// In-window frame stats: fps, points drawn and the mean CPU and GPU milliseconds per frame, drawn in the
+/// top left corner of the window on top of the plot. The text is rasterized on the CPU with a 3 x 5 pixel
+/// font into a small texture once every FRAME_STATS_OVERLAY_SECONDS, and every presented frame draws that
+/// texture on a single quad, so it also shows in fullscreen windows without a title bar.
+
+/// <summary>
+/// Texture holding the current text, and the program and vertex array that draw it.
+/// </summary>
+struct frame_overlay
+{
+	unsigned int texture;
+	unsigned int program;
+	unsigned int vertex_array;
+	int width;
+	int height;
+};
+
+/// <summary>
+/// Rows of the glyph for character, top row first, 3 bits per row with the leftmost pixel in the highest bit.
+/// Characters without a glyph are blank.
+/// </summary>
+inline uint16_t frame_overlay_glyph(char character)
+{
+	const char* characters = "0123456789.CFGMPSTU";
+	const uint16_t glyphs[] = {
+		075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757, 075717, 000002,
+		074447, 074644, 074557, 057755, 075744, 074717, 072222, 055557
+	};
+	for (int i = 0; characters[i] != '\0'; i++)
+	{
+		if (characters[i] == character)
+		{
+			return glyphs[i];
+		}
+	}
+	return 0;
+}
+
+/// <summary>
+/// Creates the texture and the program. Needs the GL context of the window to be current.
+/// </summary>
+/// <returns> true on success\n false if the program cannot be built, in which case nothing is left allocated</returns>
+inline bool frame_overlay_create(struct frame_overlay& overlay)
+{
+	// Like the frame cache quad, the corners come from gl_VertexID. rectangle is (left, bottom, right, top)
+	// in normalized device coordinates, and texels holding text are drawn white on black.
+	const char* vertex_shader_source = "#version 330 core\n\nuniform vec4 rectangle;\nout vec2 texture_coordinate;\nvoid main()\n{\n\tvec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n\ttexture_coordinate = vec2(corner.x, 1.0 - corner.y);\n\tgl_Position = vec4(mix(rectangle.xy, rectangle.zw, corner), 0.0, 1.0);\n}";
+	const char* fragment_shader_source = "#version 330 core\n\nin vec2 texture_coordinate;\nuniform sampler2D text;\nout vec4 color;\nvoid main()\n{\n\tcolor = vec4(vec3(texture(text, texture_coordinate).r), 1.0);\n}";
+
+	overlay.width = 0;
+	overlay.height = 0;
+	overlay.vertex_array = 0;
+	unsigned int vertex_shader_id = frame_cache_shader(GL_VERTEX_SHADER, vertex_shader_source);
+	unsigned int fragment_shader_id = frame_cache_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+	if ((vertex_shader_id == 0) || (fragment_shader_id == 0))
+	{
+		std::cerr << "ERROR: Frame stats overlay shaders failed to compile. The overlay is disabled.\n";
+		glDeleteShader(vertex_shader_id);
+		glDeleteShader(fragment_shader_id);
+		overlay.program = 0;
+		overlay.texture = 0;
+		return false;
+	}
+	overlay.program = glCreateProgram();
+	glAttachShader(overlay.program, vertex_shader_id);
+	glAttachShader(overlay.program, fragment_shader_id);
+	glLinkProgram(overlay.program);
+	glDeleteShader(vertex_shader_id);
+	glDeleteShader(fragment_shader_id);
+
+	int link_result;
+	glGetProgramiv(overlay.program, GL_LINK_STATUS, &link_result);
+	if (link_result == GL_FALSE)
+	{
+		std::cerr << "ERROR: Frame stats overlay program failed to link. The overlay is disabled.\n";
+		glDeleteProgram(overlay.program);
+		overlay.program = 0;
+		overlay.texture = 0;
+		return false;
+	}
+
+	glGenTextures(1, &overlay.texture);
+	glBindTexture(GL_TEXTURE_2D, overlay.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glGenVertexArrays(1, &overlay.vertex_array);
+	return true;
+}
+
+inline void frame_overlay_destroy(struct frame_overlay& overlay)
+{
+	glDeleteVertexArrays(1, &overlay.vertex_array);
+	glDeleteProgram(overlay.program);
+	glDeleteTextures(1, &overlay.texture);
+	memory_freed(memory_stage_get(MEMORY_STAGE_GL_TEXTURES), (size_t)overlay.width * overlay.height);
+}
+
+/// <summary>
+/// Rasterizes the lines of text, one pixel of spacing around every glyph, and uploads them as the texture.
+/// </summary>
+inline void frame_overlay_text(struct frame_overlay& overlay, const std::vector<std::string>& lines)
+{
+	size_t columns = 0;
+	for (size_t l = 0; l < lines.size(); l++)
+	{
+		columns = (lines[l].size() > columns) ? lines[l].size() : columns;
+	}
+	int width = (int)(columns * (FRAME_OVERLAY_GLYPH_WIDTH + 1)) + 1;
+	int height = (int)(lines.size() * (FRAME_OVERLAY_GLYPH_HEIGHT + 1)) + 1;
+	std::vector<unsigned char> texels((size_t)width * height, 0);
+	for (size_t l = 0; l < lines.size(); l++)
+	{
+		for (size_t c = 0; c < lines[l].size(); c++)
+		{
+			uint16_t glyph = frame_overlay_glyph(lines[l][c]);
+			for (int row = 0; row < FRAME_OVERLAY_GLYPH_HEIGHT; row++)
+			{
+				for (int column = 0; column < FRAME_OVERLAY_GLYPH_WIDTH; column++)
+				{
+					int bit = ((FRAME_OVERLAY_GLYPH_HEIGHT - 1 - row) * FRAME_OVERLAY_GLYPH_WIDTH) + (FRAME_OVERLAY_GLYPH_WIDTH - 1 - column);
+					size_t y = (l * (FRAME_OVERLAY_GLYPH_HEIGHT + 1)) + 1 + row;
+					size_t x = (c * (FRAME_OVERLAY_GLYPH_WIDTH + 1)) + 1 + column;
+					texels[(y * width) + x] = ((glyph >> bit) & 1) ? 255 : 0;
+				}
+			}
+		}
+	}
+
+	// Rows of single bytes are not 4 byte aligned in general.
+	int alignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, overlay.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+	memory_freed(memory_stage_get(MEMORY_STAGE_GL_TEXTURES), (size_t)overlay.width * overlay.height);
+	memory_gl_allocated(MEMORY_STAGE_GL_TEXTURES, (size_t)width * height);
+	overlay.width = width;
+	overlay.height = height;
+}
+
+/// <summary>
+/// Whether FRAME_STATS_OVERLAY_SECONDS have passed since the overlay was last updated.
+/// </summary>
+inline bool frame_overlay_due(const struct frame_stats& stats)
+{
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stats.overlay_start).count();
+	return seconds >= FRAME_STATS_OVERLAY_SECONDS;
+}
+
+/// <summary>
+/// Once every FRAME_STATS_OVERLAY_SECONDS, writes fps, points drawn and the mean CPU and GPU milliseconds
+/// per frame since the last update into the overlay, and starts a new averaging window.
+/// </summary>
+inline void frame_overlay_update(struct frame_overlay& overlay, struct frame_stats& stats)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(now - stats.overlay_start).count();
+	if ((seconds < FRAME_STATS_OVERLAY_SECONDS) || (stats.overlay_frames == 0))
+	{
+		return;
+	}
+	std::vector<std::string> lines;
+	std::ostringstream text;
+	text.setf(std::ios::fixed);
+	text.precision(1);
+	text << "FPS " << stats.overlay_frames / seconds;
+	lines.push_back(text.str());
+	text.str("");
+	text << "PTS " << stats.points;
+	lines.push_back(text.str());
+	text.str("");
+	text << "CPU " << stats.overlay_cpu / stats.overlay_frames << " MS";
+	lines.push_back(text.str());
+	text.str("");
+	if (stats.overlay_gpu_samples > 0)
+	{
+		text << "GPU " << stats.overlay_gpu / stats.overlay_gpu_samples << " MS";
+		lines.push_back(text.str());
+	}
+	frame_overlay_text(overlay, lines);
+
+	stats.overlay_start = now;
+	stats.overlay_frames = 0;
+	stats.overlay_cpu = 0.0;
+	stats.overlay_gpu = 0.0;
+	stats.overlay_gpu_samples = 0;
+}
+
+/// <summary>
+/// Draws the text in the top left corner of the window, whose framebuffer is window_width x window_height.
+/// Nothing is drawn before the first update. The program and vertex array in use before the call are
+/// restored afterwards.
+/// </summary>
+inline void frame_overlay_draw(const struct frame_overlay& overlay, int window_width, int window_height)
+{
+	if ((overlay.width == 0) || (window_width == 0) || (window_height == 0))
+	{
+		return;
+	}
+	int program_id;
+	int vertex_array;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program_id);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertex_array);
+
+	float left = -1.0f + ((2.0f * FRAME_OVERLAY_MARGIN) / window_width);
+	float top = 1.0f - ((2.0f * FRAME_OVERLAY_MARGIN) / window_height);
+	float right = left + ((2.0f * FRAME_OVERLAY_SCALE * overlay.width) / window_width);
+	float bottom = top - ((2.0f * FRAME_OVERLAY_SCALE * overlay.height) / window_height);
+	glUseProgram(overlay.program);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, overlay.texture);
+	glUniform1i(glGetUniformLocation(overlay.program, "text"), 0);
+	glUniform4f(glGetUniformLocation(overlay.program, "rectangle"), left, bottom, right, top);
+	glBindVertexArray(overlay.vertex_array);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	glBindVertexArray(vertex_array);
+	glUseProgram(program_id);
+}
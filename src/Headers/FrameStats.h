@@ -0,0 +1,185 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#define FRAME_STATS_QUERIES 2
+#define FRAME_STATS_BUCKET_MS 0.05
+#define FRAME_STATS_BUCKETS 10000
+#define FRAME_STATS_OVERLAY_SECONDS 1.0
+
+/// \file
+/// Per-frame timing of the render loops: the CPU time of a frame and the GPU time of its commands, measured
+/// with GL_TIME_ELAPSED queries. The queries are double buffered: a frame reads back the query of the frame
+/// before the previous one, whose result is normally long available, and skips the sample instead of
+/// waiting if it is not, so measuring never stalls the pipeline.
+
+/// <summary>
+/// Fixed-width histogram of frame times in milliseconds. Times beyond the last bucket are counted in it.
+/// </summary>
+struct frame_histogram
+{
+	std::vector<unsigned long> buckets;
+	unsigned long count;
+	double total;
+	double max;
+};
+
+/// <summary>
+/// Timing state of a render loop, see frame_stats_begin() and frame_stats_end().
+/// </summary>
+struct frame_stats
+{
+	unsigned int queries[FRAME_STATS_QUERIES];
+	bool pending[FRAME_STATS_QUERIES];
+	unsigned long frame;
+	unsigned long skipped;
+	std::chrono::steady_clock::time_point frame_start;
+	struct frame_histogram cpu;
+	struct frame_histogram gpu;
+	// Overlay window: frames, points and time since the overlay was last updated, see FrameOverlay.h.
+	std::chrono::steady_clock::time_point overlay_start;
+	unsigned long overlay_frames;
+	double overlay_cpu;
+	double overlay_gpu;
+	unsigned long overlay_gpu_samples;
+	long points;
+};
+
+inline void frame_histogram_add(struct frame_histogram& histogram, double milliseconds)
+{
+	long bucket = (long)(milliseconds / FRAME_STATS_BUCKET_MS);
+	bucket = (bucket < 0) ? 0 : ((bucket >= FRAME_STATS_BUCKETS) ? (FRAME_STATS_BUCKETS - 1) : bucket);
+	histogram.buckets[bucket] = histogram.buckets[bucket] + 1;
+	histogram.count = histogram.count + 1;
+	histogram.total = histogram.total + milliseconds;
+	histogram.max = (milliseconds > histogram.max) ? milliseconds : histogram.max;
+}
+
+/// <summary>
+/// Upper edge of the bucket holding the given fraction of the samples, e.g. 0.95 for p95.
+/// </summary>
+inline double frame_histogram_percentile(const struct frame_histogram& histogram, double fraction)
+{
+	unsigned long rank = (unsigned long)(fraction * histogram.count);
+	unsigned long seen = 0;
+	for (long b = 0; b < FRAME_STATS_BUCKETS; b++)
+	{
+		seen = seen + histogram.buckets[b];
+		if ((seen > rank) || (seen == histogram.count))
+		{
+			return (b + 1) * FRAME_STATS_BUCKET_MS;
+		}
+	}
+	return 0.0;
+}
+
+/// <summary>
+/// Creates the queries. Needs the GL context of the window to be current.
+/// </summary>
+inline void frame_stats_create(struct frame_stats& stats)
+{
+	glGenQueries(FRAME_STATS_QUERIES, stats.queries);
+	for (int q = 0; q < FRAME_STATS_QUERIES; q++)
+	{
+		stats.pending[q] = false;
+	}
+	stats.frame = 0;
+	stats.skipped = 0;
+	struct frame_histogram empty = { std::vector<unsigned long>(FRAME_STATS_BUCKETS, 0), 0, 0.0, 0.0 };
+	stats.cpu = empty;
+	stats.gpu = empty;
+	stats.overlay_start = std::chrono::steady_clock::now();
+	stats.overlay_frames = 0;
+	stats.overlay_cpu = 0.0;
+	stats.overlay_gpu = 0.0;
+	stats.overlay_gpu_samples = 0;
+	stats.points = 0;
+}
+
+inline void frame_stats_destroy(struct frame_stats& stats)
+{
+	glDeleteQueries(FRAME_STATS_QUERIES, stats.queries);
+}
+
+/// <summary>
+/// Starts measuring a frame. Collects the GPU time of the last frame that used this frame's query, if it
+/// is available by now.
+/// </summary>
+inline void frame_stats_begin(struct frame_stats& stats)
+{
+	int slot = stats.frame % FRAME_STATS_QUERIES;
+	if (stats.pending[slot])
+	{
+		int available = 0;
+		glGetQueryObjectiv(stats.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(stats.queries[slot], GL_QUERY_RESULT, &nanoseconds);
+			double milliseconds = nanoseconds / 1000000.0;
+			frame_histogram_add(stats.gpu, milliseconds);
+			stats.overlay_gpu = stats.overlay_gpu + milliseconds;
+			stats.overlay_gpu_samples = stats.overlay_gpu_samples + 1;
+		}
+		else
+		{
+			stats.skipped = stats.skipped + 1;
+		}
+	}
+	stats.frame_start = std::chrono::steady_clock::now();
+	glBeginQuery(GL_TIME_ELAPSED, stats.queries[slot]);
+	stats.pending[slot] = true;
+}
+
+/// <summary>
+/// Ends the frame started by frame_stats_begin(). Call it after glfwSwapBuffers(), so that the CPU time
+/// includes the swap.
+/// </summary>
+/// <param name="points"> Number of points the frame drew, shown by the overlay</param>
+inline void frame_stats_end(struct frame_stats& stats, long points)
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double milliseconds = std::chrono::duration<double, std::milli>(now - stats.frame_start).count();
+	frame_histogram_add(stats.cpu, milliseconds);
+	stats.frame = stats.frame + 1;
+	stats.overlay_frames = stats.overlay_frames + 1;
+	stats.overlay_cpu = stats.overlay_cpu + milliseconds;
+	stats.points = points;
+}
+
+/// <summary>
+/// Drops the frame started by frame_stats_begin(), e.g. when an event-driven loop woke up without drawing.
+/// </summary>
+inline void frame_stats_cancel(struct frame_stats& stats)
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	stats.pending[stats.frame % FRAME_STATS_QUERIES] = false;
+}
+
+inline void frame_histogram_report(std::ostream& out, const char* name, const struct frame_histogram& histogram)
+{
+	out << name << ": " << histogram.count << " samples";
+	if (histogram.count > 0)
+	{
+		out << ", mean " << histogram.total / histogram.count << " ms, p50 " << frame_histogram_percentile(histogram, 0.50) <<
+			" ms, p95 " << frame_histogram_percentile(histogram, 0.95) << " ms, p99 " << frame_histogram_percentile(histogram, 0.99) <<
+			" ms, max " << histogram.max << " ms";
+	}
+	out << "\n";
+}
+
+/// <summary>
+/// Prints the frame count and the CPU and GPU frame time percentiles, e.g. when the window is closed.
+/// </summary>
+inline void frame_stats_report(const struct frame_stats& stats, std::ostream& out)
+{
+	out << "Frames: " << stats.frame << ". GPU samples skipped because they were not ready: " << stats.skipped << ".\n";
+	frame_histogram_report(out, "CPU frame time", stats.cpu);
+	frame_histogram_report(out, "GPU frame time", stats.gpu);
+}
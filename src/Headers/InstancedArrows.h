@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+
+#include <GL/glew.h>
+
+#include "MemoryStats.h"
+
+#define INSTANCE_STRIDE 7
+#define ARROW_MESH_VERTICES 6
+
+/// \file
+/// Instanced arrows for the vector field programs. Instead of rasterizing the shaft and the arrowhead of
+/// every arrow, a single instance (x, y, r, g, b, x_vector, y_vector) is stored per arrow, and the vertex
+/// shader scales and rotates one shared glyph mesh onto it. Draw with
+/// glDrawArraysInstanced(GL_LINES, 0, ARROW_MESH_VERTICES, instances).
+
+/// <summary>
+/// Appends the instance of the arrow from (x, y) along (x_vector, y_vector). The color slots are left at 0
+/// for the shading pass, which reads the position at the start of the instance and writes the color 2 floats
+/// after it.
+/// </summary>
+inline void instanced_arrow_append(counted_vector<float, instance_data_memory>& instance_data, long x, long y, long x_vector, long y_vector)
+{
+	float instance[INSTANCE_STRIDE] = { (float)x, (float)y, 0.0f, 0.0f, 0.0f, (float)x_vector, (float)y_vector };
+	instance_data.insert(instance_data.end(), instance, instance + INSTANCE_STRIDE);
+}
+
+/// <summary>
+/// Compiles and binds the program that scales and rotates the arrow glyph in the vertex shader. It does not
+/// depend on the instances, so it can be built while they are still being computed.
+/// </summary>
+/// <param name="link"> Callable taking (vertex shader source, fragment shader source) and returning the linked program</param>
+/// <param name="window_width"> Width of the window, whose origin is at its center</param>
+/// <param name="window_height"> Height of the window</param>
+/// <returns> The program, bound with glUseProgram</returns>
+template <typename Link>
+unsigned int instanced_arrows_program(Link link, long window_width, long window_height)
+{
+	std::string vertex_shader_source = "#version 330 core\n\nlayout(location = 0) in vec3 glyph;\nlayout(location = 1) in vec2 origin;\nlayout(location = 2) in vec3 color;\nlayout(location = 3) in vec2 field;\nuniform vec2 half_extent;\nout vec4 color_data;\nvoid main()\n{\n\tfloat field_length = length(field);\n\tvec2 unit = (field_length > 0.0) ? field / field_length : vec2(0.0);\n\tvec2 normal = vec2(-unit.y, unit.x);\n\tvec2 position = origin + glyph.x * field + 3.0 * (glyph.y * unit + glyph.z * normal);\n\tgl_Position = vec4(position / half_extent, 0.0, 1.0);\n\tcolor_data = vec4(color, 1.0);\n}";
+	std::string fragment_shader_source = "#version 330 core\n\nin vec4 color_data;\nout vec4 color;\nvoid main()\n{\n\tcolor = color_data;\n}";
+
+	unsigned int program_id = link(vertex_shader_source, fragment_shader_source);
+	glUseProgram(program_id);
+	glUniform2f(glGetUniformLocation(program_id, "half_extent"), window_width / 2, window_height / 2);
+	return program_id;
+}
+
+/// <summary>
+/// Uploads the arrow glyph mesh and the instances. The mesh vertices are (along vector, along unit direction,
+/// along normal), so that the shaft ends at origin + vector and the two head strokes match the arrowhead
+/// stamps drawn by the programs.
+/// </summary>
+/// @warning Needs the GL context of the window to be current.
+inline void upload_instanced_arrows(const counted_vector<float, instance_data_memory>& instance_data)
+{
+	float arrow_mesh[] = {
+		0.0f, 0.0f, 0.0f,    1.0f, 0.0f, 0.0f,
+		1.0f, 0.0f, 0.0f,    1.0f, -1.0f, 1.0f,
+		1.0f, 0.0f, 0.0f,    1.0f, -1.0f, -1.0f
+	};
+
+	unsigned int buffers[2];
+	glGenBuffers(2, buffers);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(arrow_mesh), arrow_mesh, GL_STATIC_DRAW);
+	memory_gl_allocated(MEMORY_STAGE_GL_BUFFERS, sizeof(arrow_mesh));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, 0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+	glBufferData(GL_ARRAY_BUFFER, instance_data.size() * sizeof(float), instance_data.data(), GL_STATIC_DRAW);
+	memory_gl_allocated(MEMORY_STAGE_GL_BUFFERS, instance_data.size() * sizeof(float));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * INSTANCE_STRIDE, 0);
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(float) * INSTANCE_STRIDE, (const void*)(sizeof(float) * 2));
+	glVertexAttribDivisor(2, 1);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(float) * INSTANCE_STRIDE, (const void*)(sizeof(float) * 5));
+	glVertexAttribDivisor(3, 1);
+}
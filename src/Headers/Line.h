@@ -1,43 +1,61 @@
-#pragma once
-#include <cassert>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-#include <vector>
-#include <random>
-#include <chrono>
-#include <algorithm>
-
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
-
-#define VERTEX_SHADER_FILENAME "vertex_shader.glsl"
-#define FRAGMENT_SHADER_FILENAME "fragment_shader.glsl"
-#define MIN_DROPOFF_RADIUS 3 * std::max(window_width, window_height) / 4
-#define MAX_DROPOFF_RADIUS std::max(window_width, window_height)
-#define SIMILARITY_THRESHOLD 50
-#define LENGTH_SPLIT 4
-#define WIDTH_SPLIT 4
-
-class Line {
-public:
-	int x_initial;
-	int y_initial;
-	int x_final;
-	int y_final;
-	std::vector<float> point_data;
-	Line();
-	Line(int x_initial, int y_initial, int x_final, int y_final);
-	int process(int window_width, int window_height);
-	void plot();
-
-private:
-	std::string file_string_transfer(std::ifstream& in);
-	double compute_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2);
-	int16_t main_helper_verifybounds_int16_t(int16_t check);
-	void compute_color(std::vector<float>& point_data, std::vector<struct basepoint> basepoints);
-	struct basepoint basepoint_layout_helper(uint64_t length_l, uint64_t length_r, uint64_t width_u, uint64_t width_d, std::vector<struct basepoint> basepoints, int window_width, int window_height);
-	unsigned int shader_compile(unsigned int shader_type, const std::string& source_code);
-	unsigned int shaders_link_and_generate_program(const std::string& vertex_shader, const std::string& fragment_shader);
-
+#pragma once
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <future>
+#include <mutex>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "Clipping.h"
+#include "Rasterizer.h"
+#include "Parallel.h"
+#include "PixelGenerators.h"
+#include "Trace.h"
+#include "MemoryStats.h"
+#include "Arena.h"
+
+#define VERTEX_SHADER_FILENAME "vertex_shader.glsl"
+#define FRAGMENT_SHADER_FILENAME "fragment_shader.glsl"
+#define MIN_DROPOFF_RADIUS 3 * std::max(window_width, window_height) / 4
+#define MAX_DROPOFF_RADIUS std::max(window_width, window_height)
+#define SIMILARITY_THRESHOLD 50
+#define LENGTH_SPLIT 4
+#define WIDTH_SPLIT 4
+#define PARALLEL_LINE_MIN_POINTS 16384
+
+class Line {
+public:
+	int x_initial;
+	int y_initial;
+	int x_final;
+	int y_final;
+	struct slice<float> point_data;
+	Arena* arena;
+	Line();
+	Line(int x_initial, int y_initial, int x_final, int y_final, Arena& arena = scene_arena());
+	int process(int window_width, int window_height);
+	std::future<int> process_async(int window_width, int window_height, long lane = 0);
+	int compute(int window_width, int window_height, long lane = 0);
+	void upload();
+	void build_program();
+	void plot();
+	class line_pixels pixels(int window_width, int window_height) const;
+
+private:
+	std::string file_string_transfer(std::ifstream& in);
+	double compute_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2);
+	int16_t main_helper_verifybounds_int16_t(int16_t check);
+	void shade_vertex(const float* position, float* color, const counted_vector<struct basepoint, basepoint_memory>& basepoints);
+	void rasterize_segment(float* vertices, long first, long last);
+	struct basepoint basepoint_layout_helper(uint64_t length_l, uint64_t length_r, uint64_t width_u, uint64_t width_d, const counted_vector<struct basepoint, basepoint_memory>& basepoints, int window_width, int window_height);
+	unsigned int shader_compile(unsigned int shader_type, const std::string& source_code);
+	unsigned int shaders_link_and_generate_program(const std::string& vertex_shader, const std::string& fragment_shader);
+
 };
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+#ifndef MEMORY_REPORT
+#define MEMORY_REPORT 0
+#endif
+
+#define MEMORY_STAGE_ARENA "arena chunks"
+#define MEMORY_STAGE_GL_BUFFERS "GL buffers"
+#define MEMORY_STAGE_GL_TEXTURES "GL textures"
+
+/// \file
+/// Memory accounting per stage: bytes currently held, the peak, and how many allocations and frees it took
+/// to get there. Vectors take part by using counting_allocator, e.g. counted_vector<float, point_data_memory>,
+/// other owners (arena chunks, GL buffers, GL textures) call memory_allocated() and memory_freed()
+/// themselves. A growing vector shows up as many allocations for few bytes, which is what reallocation churn
+/// looks like.
+/// memory_report() writes every stage and the peak resident set size as one line of JSON.
+
+/// <summary>
+/// Counters of one stage. Updated with relaxed atomics, so any thread may allocate.
+/// </summary>
+struct memory_stage
+{
+	std::string name;
+	std::atomic<long long> current{ 0 };
+	std::atomic<long long> peak{ 0 };
+	std::atomic<long long> allocations{ 0 };
+	std::atomic<long long> frees{ 0 };
+};
+
+struct memory_registry
+{
+	std::mutex lock;
+	std::vector<std::unique_ptr<struct memory_stage>> stages;
+};
+
+inline struct memory_registry& memory_registry_get()
+{
+	static struct memory_registry registry;
+	return registry;
+}
+
+/// <summary>
+/// The stage with the given name, created on first use. Stages are reported in the order they were created.
+/// </summary>
+inline struct memory_stage& memory_stage_get(const char* name)
+{
+	struct memory_registry& registry = memory_registry_get();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	for (size_t s = 0; s < registry.stages.size(); s++)
+	{
+		if (registry.stages[s]->name == name)
+		{
+			return *registry.stages[s];
+		}
+	}
+	registry.stages.emplace_back(new struct memory_stage);
+	registry.stages.back()->name = name;
+	return *registry.stages.back();
+}
+
+inline void memory_allocated(struct memory_stage& stage, size_t bytes)
+{
+	long long current = stage.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	long long peak = stage.peak.load(std::memory_order_relaxed);
+	while ((current > peak) && !stage.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+	{
+	}
+	stage.allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void memory_freed(struct memory_stage& stage, size_t bytes)
+{
+	stage.current.fetch_sub(bytes, std::memory_order_relaxed);
+	stage.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Standard allocator that books every allocation to the stage named by Stage::name. Stage is an empty tag
+/// type, so the allocator is stateless and vectors using it copy, move and swap like plain vectors.
+/// </summary>
+template <typename T, typename Stage>
+struct counting_allocator
+{
+	typedef T value_type;
+
+	counting_allocator() = default;
+
+	template <typename U>
+	counting_allocator(const counting_allocator<U, Stage>&)
+	{
+	}
+
+	static struct memory_stage& stage()
+	{
+		static struct memory_stage& counted = memory_stage_get(Stage::name);
+		return counted;
+	}
+
+	T* allocate(size_t count)
+	{
+		T* memory = std::allocator<T>().allocate(count);
+		memory_allocated(stage(), count * sizeof(T));
+		return memory;
+	}
+
+	void deallocate(T* memory, size_t count)
+	{
+		memory_freed(stage(), count * sizeof(T));
+		std::allocator<T>().deallocate(memory, count);
+	}
+};
+
+template <typename T, typename U, typename Stage>
+bool operator==(const counting_allocator<T, Stage>&, const counting_allocator<U, Stage>&)
+{
+	return true;
+}
+
+template <typename T, typename U, typename Stage>
+bool operator!=(const counting_allocator<T, Stage>&, const counting_allocator<U, Stage>&)
+{
+	return false;
+}
+
+template <typename T, typename Stage>
+using counted_vector = std::vector<T, counting_allocator<T, Stage>>;
+
+/// Stages shared by the drivers and the shape classes.
+struct point_data_memory { static constexpr const char* name = "point_data"; };
+struct instance_data_memory { static constexpr const char* name = "instance_data"; };
+struct basepoint_memory { static constexpr const char* name = "basepoints"; };
+struct vertex_store_memory { static constexpr const char* name = "vertex_store"; };
+struct cell_plan_memory { static constexpr const char* name = "cell plans"; };
+
+/// <summary>
+/// Books a glBufferData() or glTexImage2D() of the given size. The drivers keep their buffers until exit, so
+/// only frame_cache_destroy() hands memory back.
+/// </summary>
+inline void memory_gl_allocated(const char* stage, size_t bytes)
+{
+	memory_allocated(memory_stage_get(stage), bytes);
+}
+
+/// <summary>
+/// Peak resident set size of the process in bytes, or -1 where it is not known.
+/// </summary>
+inline long long memory_peak_rss()
+{
+#ifdef __unix__
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		// Kilobytes on Linux.
+		return (long long)usage.ru_maxrss * 1024;
+	}
+#endif
+	return -1;
+}
+
+/// <summary>
+/// Writes one line of JSON, e.g.
+/// {"memory":{"where":"main","peak_rss_bytes":123,"stages":[{"name":"point_data","current_bytes":0,...}]}}
+/// so that scripts can pick it out of the output and compare runs.
+/// </summary>
+/// <param name="where"> Where the report was taken, e.g. the function name</param>
+inline void memory_report(std::ostream& out, const char* where)
+{
+	struct memory_registry& registry = memory_registry_get();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	out << "{\"memory\":{\"where\":\"" << where << "\",\"peak_rss_bytes\":" << memory_peak_rss() << ",\"stages\":[";
+	for (size_t s = 0; s < registry.stages.size(); s++)
+	{
+		const struct memory_stage& stage = *registry.stages[s];
+		out << ((s == 0) ? "" : ",") << "{\"name\":\"" << stage.name << "\",\"current_bytes\":" << stage.current.load() <<
+			",\"peak_bytes\":" << stage.peak.load() << ",\"allocations\":" << stage.allocations.load() <<
+			",\"frees\":" << stage.frees.load() << "}";
+	}
+	out << "]}}\n";
+}
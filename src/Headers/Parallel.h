@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "Trace.h"
+
+#define PARALLEL_SHADE_MIN_POINTS 4096
+
+/// \file
+
+/// <summary>
+/// Number of worker threads used by parallel_for_chunks, at least 1.
+/// </summary>
+inline long parallel_worker_count()
+{
+	long workers = std::thread::hardware_concurrency();
+	return (workers > 0) ? workers : 1;
+}
+
+/// <summary>
+/// Splits [begin, end) into one contiguous chunk per worker and calls task(chunk_begin, chunk_end, worker)
+/// for each of them on its own thread. Returns once every chunk is done.
+/// </summary>
+/// <param name="begin"> First index of the range</param>
+/// <param name="end"> One past the last index of the range</param>
+/// <param name="task"> Callable taking (long chunk_begin, long chunk_end, long worker)</param>
+/// <returns> Number of workers the range was split into</returns>
+template <typename Task>
+long parallel_for_chunks(long begin, long end, Task task)
+{
+	long count = end - begin;
+	if (count <= 0)
+	{
+		return 0;
+	}
+	long workers = std::min(parallel_worker_count(), count);
+	long chunk = (count + workers - 1) / workers;
+
+	std::vector<std::thread> threads;
+	for (long worker = 0; worker < workers; worker++)
+	{
+		long chunk_begin = begin + (worker * chunk);
+		long chunk_end = std::min(end, chunk_begin + chunk);
+		if (chunk_begin >= chunk_end)
+		{
+			break;
+		}
+		threads.emplace_back(task, chunk_begin, chunk_end, worker);
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+	return threads.size();
+}
+
+/// <summary>
+/// Splits the items [0, n) into one contiguous range per worker so that every range carries about the same
+/// weight, and calls task(item_begin, item_end, worker) for each of them on its own thread. Used instead of
+/// parallel_for_chunks when the cost of an item varies a lot and is known in advance.
+/// </summary>
+/// <param name="prefix"> n + 1 non-decreasing entries, prefix[i] being the total weight of the items before i</param>
+/// <param name="task"> Callable taking (long item_begin, long item_end, long worker)</param>
+/// <returns> Number of workers the items were split into</returns>
+template <typename Task>
+long parallel_for_balanced(const std::vector<long>& prefix, Task task)
+{
+	long count = prefix.size() - 1;
+	if (count <= 0)
+	{
+		return 0;
+	}
+	long workers = std::min(parallel_worker_count(), count);
+	long total = prefix.back() - prefix.front();
+
+	std::vector<std::thread> threads;
+	long item_begin = 0;
+	for (long worker = 0; (worker < workers) && (item_begin < count); worker++)
+	{
+		// Each range ends at the first item boundary reaching its share of the total weight.
+		long item_end = count;
+		if (worker < (workers - 1))
+		{
+			long target = prefix.front() + ((total * (worker + 1)) / workers);
+			item_end = std::lower_bound(prefix.begin(), prefix.end(), target) - prefix.begin();
+			item_end = std::min(count, std::max(item_begin + 1, item_end));
+		}
+		threads.emplace_back(task, item_begin, item_end, worker);
+		item_begin = item_end;
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+	return threads.size();
+}
+
+/// <summary>
+/// Shading pass over count vertices. Calls shade(position, color) on every vertex, split across threads by
+/// parallel_for_chunks once count reaches PARALLEL_SHADE_MIN_POINTS. Since vertices are independent, this
+/// scales with cores even when the geometry that produced them had to be walked serially.
+/// Interleaved (x, y, r, g, b) vertices use strides 5 and 5 with colors = positions + 2; separate position
+/// and color streams use strides 2 and 3.
+/// </summary>
+/// <param name="positions"> (x, y) of the first vertex, PositionStride floats apart</param>
+/// <param name="colors"> (r, g, b) of the first vertex, ColorStride floats apart</param>
+/// <param name="shade"> Callable taking (const float* position, float* color), safe to call from several threads at once</param>
+template <long PositionStride, long ColorStride, typename Shade>
+void parallel_shade(const float* positions, float* colors, long count, Shade shade)
+{
+	TRACE_COUNTER("color evaluations", count);
+	if (count < PARALLEL_SHADE_MIN_POINTS)
+	{
+		TRACE_ZONE("shade");
+		for (long i = 0; i < count; i++)
+		{
+			shade(positions + (PositionStride * i), colors + (ColorStride * i));
+		}
+		return;
+	}
+	parallel_for_chunks(0, count, [positions, colors, &shade](long chunk_begin, long chunk_end, long /* worker */)
+	{
+		TRACE_ZONE("shade");
+		for (long i = chunk_begin; i < chunk_end; i++)
+		{
+			shade(positions + (PositionStride * i), colors + (ColorStride * i));
+		}
+	});
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define PERF_COUNTER_CYCLES 0
+#define PERF_COUNTER_INSTRUCTIONS 1
+#define PERF_COUNTER_CACHE_MISSES 2
+#define PERF_COUNTER_BRANCH_MISSES 3
+#define PERF_COUNTER_COUNT 4
+
+/// \file
+/// Hardware performance counters around a kernel: cycles, instructions, cache misses and branch misses,
+/// read through perf_event_open on Linux. The counters follow the opening thread and every thread it starts
+/// afterwards, so the workers of parallel_for_chunks are included. Where the counters cannot be opened
+/// (containers, a strict perf_event_paranoid, other systems) only the wall time is reported.
+
+/// <summary>
+/// Counters of the calling thread. A counter that could not be opened has fd -1.
+/// </summary>
+struct perf_counters
+{
+	int fds[PERF_COUNTER_COUNT];
+	bool available;
+	std::string unavailable_reason;
+	std::chrono::steady_clock::time_point start;
+	uint64_t baseline[PERF_COUNTER_COUNT][3];
+};
+
+/// <summary>
+/// Counter values of one measurement, scaled up if the kernel had to multiplex the counters. valid is false
+/// for counters that are not available.
+/// </summary>
+struct perf_reading
+{
+	double values[PERF_COUNTER_COUNT];
+	bool valid[PERF_COUNTER_COUNT];
+	double milliseconds;
+};
+
+/// <summary>
+/// Opens the counters, disabled, for the calling thread and the threads it creates from now on.
+/// </summary>
+/// <returns> true if at least one counter is available</returns>
+inline bool perf_counters_open(struct perf_counters& counters)
+{
+	counters.available = false;
+	for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+	{
+		counters.fds[c] = -1;
+	}
+#ifdef __linux__
+	const uint64_t configs[PERF_COUNTER_COUNT] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+	int error = 0;
+	for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+	{
+		struct perf_event_attr attributes;
+		std::memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.config = configs[c];
+		attributes.disabled = 1;
+		attributes.inherit = 1;
+		// User space only, which is also what an unprivileged process is allowed to count.
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		counters.fds[c] = syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+		if (counters.fds[c] < 0)
+		{
+			error = errno;
+			counters.fds[c] = -1;
+		}
+		counters.available = counters.available || (counters.fds[c] >= 0);
+	}
+	if (!counters.available)
+	{
+		counters.unavailable_reason = std::string("perf_event_open failed: ") + std::strerror(error);
+	}
+#else
+	counters.unavailable_reason = "hardware counters are only read on Linux";
+#endif
+	return counters.available;
+}
+
+inline void perf_counters_close(struct perf_counters& counters)
+{
+#ifdef __linux__
+	for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+	{
+		if (counters.fds[c] >= 0)
+		{
+			close(counters.fds[c]);
+			counters.fds[c] = -1;
+		}
+	}
+#endif
+	counters.available = false;
+}
+
+/// <summary>
+/// Reads value, time enabled and time running of one counter, including the counts folded in from inherited
+/// threads that have exited.
+/// </summary>
+/// <returns> false if the counter could not be read</returns>
+inline bool perf_counter_read(int fd, uint64_t* data)
+{
+#ifdef __linux__
+	return read(fd, data, 3 * sizeof(uint64_t)) == (ssize_t)(3 * sizeof(uint64_t));
+#else
+	return false;
+#endif
+}
+
+/// <summary>
+/// Starts the counters and the wall clock. PERF_EVENT_IOC_RESET only clears the count of the opening thread,
+/// not what exited workers of an earlier kernel folded in, so the counters are read here and perf_counters_stop()
+/// reports the difference.
+/// </summary>
+inline void perf_counters_start(struct perf_counters& counters)
+{
+#ifdef __linux__
+	for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+	{
+		if (counters.fds[c] >= 0)
+		{
+			if (!perf_counter_read(counters.fds[c], counters.baseline[c]))
+			{
+				counters.baseline[c][0] = 0;
+				counters.baseline[c][1] = 0;
+				counters.baseline[c][2] = 0;
+			}
+			ioctl(counters.fds[c], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+	counters.start = std::chrono::steady_clock::now();
+}
+
+/// <summary>
+/// Stops the counters and reads what they counted since perf_counters_start(). Counts of worker threads are
+/// only included once the workers have exited, as they have when parallel_for_chunks returns.
+/// </summary>
+inline struct perf_reading perf_counters_stop(struct perf_counters& counters)
+{
+	struct perf_reading reading;
+	reading.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - counters.start).count();
+	for (int c = 0; c < PERF_COUNTER_COUNT; c++)
+	{
+		reading.values[c] = 0.0;
+		reading.valid[c] = false;
+#ifdef __linux__
+		if (counters.fds[c] < 0)
+		{
+			continue;
+		}
+		ioctl(counters.fds[c], PERF_EVENT_IOC_DISABLE, 0);
+		// value, time enabled, time running
+		uint64_t data[3];
+		if (!perf_counter_read(counters.fds[c], data))
+		{
+			continue;
+		}
+		uint64_t value = data[0] - counters.baseline[c][0];
+		uint64_t enabled = data[1] - counters.baseline[c][1];
+		uint64_t running = data[2] - counters.baseline[c][2];
+		if (running > 0)
+		{
+			reading.values[c] = (double)value * ((double)enabled / (double)running);
+			reading.valid[c] = true;
+		}
+#endif
+	}
+	return reading;
+}
+
+/// <summary>
+/// Stops the counters and prints one line for the kernel: wall time, IPC, and cache and branch misses per
+/// item, e.g. per pixel. Counters that are not available are shown as n/a.
+/// </summary>
+/// <param name="items"> Number of items the kernel processed</param>
+inline struct perf_reading perf_counters_report(struct perf_counters& counters, const char* kernel, long items, std::ostream& out)
+{
+	struct perf_reading reading = perf_counters_stop(counters);
+	out << kernel << ": " << reading.milliseconds << " ms for " << items << " items";
+	if (!counters.available)
+	{
+		out << " (" << counters.unavailable_reason << ")\n";
+		return reading;
+	}
+	out << ", IPC ";
+	if (reading.valid[PERF_COUNTER_CYCLES] && reading.valid[PERF_COUNTER_INSTRUCTIONS] && (reading.values[PERF_COUNTER_CYCLES] > 0.0))
+	{
+		out << reading.values[PERF_COUNTER_INSTRUCTIONS] / reading.values[PERF_COUNTER_CYCLES];
+	}
+	else
+	{
+		out << "n/a";
+	}
+	const char* names[2] = { ", cache misses per item ", ", branch misses per item " };
+	const int indices[2] = { PERF_COUNTER_CACHE_MISSES, PERF_COUNTER_BRANCH_MISSES };
+	for (int i = 0; i < 2; i++)
+	{
+		out << names[i];
+		if (reading.valid[indices[i]] && (items > 0))
+		{
+			out << reading.values[indices[i]] / items;
+		}
+		else
+		{
+			out << "n/a";
+		}
+	}
+	out << "\n";
+	return reading;
+}
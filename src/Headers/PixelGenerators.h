@@ -0,0 +1,637 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+
+#include "Clipping.h"
+#include "Rasterizer.h"
+
+/// \file
+/// Lazy pixel generators for lines, circles, stamps (e.g. arrowheads), arrows and polylines. A generator
+/// is a range whose iterator only holds the state of the walk, and produces the next (x, y) pixel when it
+/// is advanced, so a shape can be consumed pixel by pixel without materializing its points first.
+///
+/// drain() feeds a generator into any sink of Rasterizer.h, LINE_KERNEL_LANES pixels at a time. Besides
+/// the sinks below, a strided_sink<5, float> over the memory returned by glMapBufferRange() writes the
+/// pixels straight into a GL vertex buffer.
+
+struct pixel
+{
+	int x;
+	int y;
+};
+
+/// <summary>
+/// End of every generator. An iterator compares unequal to it as long as it has pixels left.
+/// </summary>
+struct pixel_end
+{
+};
+
+/// <summary>
+/// Steps first to last (inclusive) of the Bresenham line from (x_initial, y_initial) to (x_final, y_final),
+/// in the order and with the pixels of line_scalar. The walk starts directly at step first.
+/// </summary>
+class line_pixels
+{
+public:
+	class iterator
+	{
+	public:
+		constexpr iterator(long x_initial, long y_initial, long x_final, long y_final, long first, long last)
+			: step(first), last(last)
+		{
+			long delta_x = ((x_final - x_initial) >= 0) ? (x_final - x_initial) : -(x_final - x_initial);
+			long delta_y = ((y_final - y_initial) >= 0) ? (y_final - y_initial) : -(y_final - y_initial);
+			increment_x = (x_final < x_initial) ? -1 : 1;
+			increment_y = (y_final < y_initial) ? -1 : 1;
+			x_major = delta_x > delta_y;
+			major = x_major ? delta_x : delta_y;
+			minor = x_major ? delta_y : delta_x;
+			long offset = bresenham_minor_offset(major, minor, first);
+			x = x_initial + (increment_x * (x_major ? first : offset));
+			y = y_initial + (increment_y * (x_major ? offset : first));
+			decision = bresenham_decision(major, minor, first);
+		}
+
+		constexpr struct pixel operator*() const
+		{
+			return { (int)x, (int)y };
+		}
+
+		constexpr iterator& operator++()
+		{
+			if (decision >= 0)
+			{
+				x = x_major ? x : x + increment_x;
+				y = x_major ? y + increment_y : y;
+				decision = decision + 2 * (minor - major);
+			}
+			else
+			{
+				decision = decision + 2 * minor;
+			}
+			x = x_major ? x + increment_x : x;
+			y = x_major ? y : y + increment_y;
+			step = step + 1;
+			return *this;
+		}
+
+		constexpr bool operator!=(struct pixel_end) const
+		{
+			return step <= last;
+		}
+
+	private:
+		long x = 0;
+		long y = 0;
+		long decision = 0;
+		long step;
+		long last;
+		long major = 0;
+		long minor = 0;
+		long increment_x = 1;
+		long increment_y = 1;
+		bool x_major = false;
+	};
+
+	constexpr line_pixels(long x_initial, long y_initial, long x_final, long y_final, long first, long last)
+		: x_initial(x_initial), y_initial(y_initial), x_final(x_final), y_final(y_final), first(first), last(last)
+	{
+	}
+
+	constexpr iterator begin() const
+	{
+		return iterator(x_initial, y_initial, x_final, y_final, first, last);
+	}
+
+	constexpr struct pixel_end end() const
+	{
+		return {};
+	}
+
+private:
+	long x_initial;
+	long y_initial;
+	long x_final;
+	long y_final;
+	long first;
+	long last;
+};
+
+/// <summary>
+/// Pixels of the midpoint circle inside the viewport, in the order and with the pixels of rasterize_circle.
+/// Only the up to 8 mirrors of the current step are held.
+/// </summary>
+class circle_pixels
+{
+public:
+	class iterator
+	{
+	public:
+		constexpr iterator(int x_center, int y_center, int radius, const struct viewport& view)
+			: x_center(x_center), y_center(y_center), view(view)
+		{
+			decision = 1 - radius;
+			increment_east = 3;
+			increment_southeast = (-2 * radius) + 5;
+			x = 0;
+			y = radius;
+			if (y >= x)
+			{
+				load_step();
+			}
+			skip_outside();
+		}
+
+		constexpr struct pixel operator*() const
+		{
+			return { block_x[index], block_y[index] };
+		}
+
+		constexpr iterator& operator++()
+		{
+			advance();
+			skip_outside();
+			return *this;
+		}
+
+		constexpr bool operator!=(struct pixel_end) const
+		{
+			return index < count;
+		}
+
+	private:
+		// Mirrors of (x, y) for the current step. On the octant boundaries only the distinct ones are kept,
+		// as in rasterize_circle.
+		constexpr void load_step()
+		{
+			int octants[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+			count = 8;
+			if ((x == 0) && (y == 0))
+			{
+				count = 1;
+			}
+			else if (x == 0)
+			{
+				octants[1] = 2;
+				octants[2] = 4;
+				octants[3] = 5;
+				count = 4;
+			}
+			else if (x == y)
+			{
+				count = 4;
+			}
+			for (int k = 0; k < count; k++)
+			{
+				int octant = octants[k];
+				block_x[k] = x_center + (((octant & 1) ? -1 : 1) * ((octant >= 4) ? y : x));
+				block_y[k] = y_center + (((octant & 2) ? -1 : 1) * ((octant >= 4) ? x : y));
+			}
+			index = 0;
+		}
+
+		constexpr void advance()
+		{
+			index = index + 1;
+			if (index < count)
+			{
+				return;
+			}
+
+			if (decision < 0)
+			{
+				decision = decision + increment_east;
+				increment_east = increment_east + 2;
+				increment_southeast = increment_southeast + 2;
+			}
+			else
+			{
+				decision = decision + increment_southeast;
+				increment_east = increment_east + 2;
+				increment_southeast = increment_southeast + 4;
+				y = y - 1;
+			}
+			x = x + 1;
+			if (y >= x)
+			{
+				load_step();
+			}
+		}
+
+		constexpr void skip_outside()
+		{
+			while ((index < count) && !inside_viewport(view, block_x[index], block_y[index]))
+			{
+				advance();
+			}
+		}
+
+		int x_center;
+		int y_center;
+		struct viewport view;
+		int decision = 0;
+		int increment_east = 0;
+		int increment_southeast = 0;
+		int x = 0;
+		int y = 0;
+		int block_x[8] = {};
+		int block_y[8] = {};
+		int count = 0;
+		int index = 0;
+	};
+
+	constexpr circle_pixels(int x_center, int y_center, int radius, const struct viewport& view)
+		: x_center(x_center), y_center(y_center), radius(radius), view(view)
+	{
+	}
+
+	constexpr iterator begin() const
+	{
+		return iterator(x_center, y_center, radius, view);
+	}
+
+	constexpr struct pixel_end end() const
+	{
+		return {};
+	}
+
+private:
+	int x_center;
+	int y_center;
+	int radius;
+	struct viewport view;
+};
+
+/// <summary>
+/// Fixed pattern of count (x, y) offsets placed at (x, y), e.g. an arrowhead stamp or a circle stencil.
+/// Pixels outside the viewport are skipped. The offsets are not copied and must outlive the generator.
+/// </summary>
+class stamp_pixels
+{
+public:
+	class iterator
+	{
+	public:
+		constexpr iterator(int x, int y, const int* offsets, int count, const struct viewport& view)
+			: x(x), y(y), offsets(offsets), count(count), view(view)
+		{
+			skip_outside();
+		}
+
+		constexpr struct pixel operator*() const
+		{
+			return { x + offsets[2 * index], y + offsets[(2 * index) + 1] };
+		}
+
+		constexpr iterator& operator++()
+		{
+			index = index + 1;
+			skip_outside();
+			return *this;
+		}
+
+		constexpr bool operator!=(struct pixel_end) const
+		{
+			return index < count;
+		}
+
+	private:
+		constexpr void skip_outside()
+		{
+			while ((index < count) && !inside_viewport(view, x + offsets[2 * index], y + offsets[(2 * index) + 1]))
+			{
+				index = index + 1;
+			}
+		}
+
+		int x;
+		int y;
+		const int* offsets;
+		int count;
+		struct viewport view;
+		int index = 0;
+	};
+
+	constexpr stamp_pixels(int x, int y, const int* offsets, int count, const struct viewport& view)
+		: x(x), y(y), offsets(offsets), count(count), view(view)
+	{
+	}
+
+	constexpr iterator begin() const
+	{
+		return iterator(x, y, offsets, count, view);
+	}
+
+	constexpr struct pixel_end end() const
+	{
+		return {};
+	}
+
+private:
+	int x;
+	int y;
+	const int* offsets;
+	int count;
+	struct viewport view;
+};
+
+/// <summary>
+/// Line pixels of the part of the line from (x_initial, y_initial) to (x_final, y_final) inside the viewport.
+/// </summary>
+inline class line_pixels clipped_line_pixels(const struct viewport& view, long x_initial, long y_initial,
+	long x_final, long y_final)
+{
+	long first;
+	long last;
+	if (!clip_line_steps(view, x_initial, y_initial, x_final, y_final, first, last))
+	{
+		// An empty range.
+		first = 1;
+		last = 0;
+	}
+	return line_pixels(x_initial, y_initial, x_final, y_final, first, last);
+}
+
+/// <summary>
+/// Arrow glyph: the clipped shaft from (x_initial, y_initial) to (x_final, y_final), followed by the
+/// arrowhead stamp at the tip, as drawn by the vector field programs.
+/// </summary>
+class arrow_pixels
+{
+public:
+	class iterator
+	{
+	public:
+		iterator(const class line_pixels& shaft, const class stamp_pixels& head)
+			: shaft(shaft.begin()), head(head.begin())
+		{
+		}
+
+		struct pixel operator*() const
+		{
+			return (shaft != pixel_end()) ? *shaft : *head;
+		}
+
+		iterator& operator++()
+		{
+			if (shaft != pixel_end())
+			{
+				++shaft;
+			}
+			else
+			{
+				++head;
+			}
+			return *this;
+		}
+
+		bool operator!=(struct pixel_end end) const
+		{
+			return (shaft != end) || (head != end);
+		}
+
+	private:
+		class line_pixels::iterator shaft;
+		class stamp_pixels::iterator head;
+	};
+
+	/// <param name="head_offsets"> (x, y) offsets of the arrowhead from the tip</param>
+	/// <param name="head_count"> Number of offsets</param>
+	arrow_pixels(const struct viewport& view, long x_initial, long y_initial, long x_final, long y_final,
+		const int* head_offsets, int head_count)
+		: shaft(clipped_line_pixels(view, x_initial, y_initial, x_final, y_final)),
+		head(x_final, y_final, head_offsets, head_count, view)
+	{
+	}
+
+	iterator begin() const
+	{
+		return iterator(shaft, head);
+	}
+
+	struct pixel_end end() const
+	{
+		return {};
+	}
+
+private:
+	class line_pixels shaft;
+	class stamp_pixels head;
+};
+
+/// <summary>
+/// Polyline through count vertices, given as (x, y) pairs. Every segment is clipped to the viewport and
+/// walked in full from its start, so a vertex shared by two segments is produced by both, as in the
+/// polyline program. The vertices are not copied and must outlive the generator.
+/// </summary>
+class polyline_pixels
+{
+public:
+	class iterator
+	{
+	public:
+		iterator(const long* vertices, long count, const struct viewport& view)
+			: vertices(vertices), count(count), view(view), segment(0), pixels(0, 0, 0, 0, 1, 0)
+		{
+			next_visible(0);
+		}
+
+		struct pixel operator*() const
+		{
+			return *pixels;
+		}
+
+		iterator& operator++()
+		{
+			++pixels;
+			if (!(pixels != pixel_end()))
+			{
+				next_visible(segment + 1);
+			}
+			return *this;
+		}
+
+		bool operator!=(struct pixel_end) const
+		{
+			return segment < (count - 1);
+		}
+
+	private:
+		// Moves to the first segment from start on with a visible pixel.
+		void next_visible(long start)
+		{
+			for (segment = start; segment < (count - 1); segment++)
+			{
+				const long* from = vertices + (2 * segment);
+				pixels = clipped_line_pixels(view, from[0], from[1], from[2], from[3]).begin();
+				if (pixels != pixel_end())
+				{
+					return;
+				}
+			}
+		}
+
+		const long* vertices;
+		long count;
+		struct viewport view;
+		long segment;
+		class line_pixels::iterator pixels;
+	};
+
+	polyline_pixels(const long* vertices, long count, const struct viewport& view)
+		: vertices(vertices), count(count), view(view)
+	{
+	}
+
+	iterator begin() const
+	{
+		return iterator(vertices, count, view);
+	}
+
+	struct pixel_end end() const
+	{
+		return {};
+	}
+
+private:
+	const long* vertices;
+	long count;
+	struct viewport view;
+};
+
+/// <summary>
+/// Sink that only counts the pixels, e.g. to size a buffer before filling it.
+/// </summary>
+struct count_sink
+{
+	long count;
+
+	constexpr void emit(const int* /* x */, const int* /* y */, int emitted)
+	{
+		count = count + emitted;
+	}
+};
+
+/// <summary>
+/// Sink painting the pixels into an RGB framebuffer of width x height bytes triples. Pixel (x, y) lands at
+/// (x - x_origin, y - y_origin) with y pointing up, while rows are stored from the top, so the buffer can be
+/// written out as an image directly. Pixels outside the framebuffer are dropped.
+/// </summary>
+struct framebuffer_sink
+{
+	unsigned char* pixels;
+	long width;
+	long height;
+	long x_origin;
+	long y_origin;
+	unsigned char red;
+	unsigned char green;
+	unsigned char blue;
+
+	void emit(const int* x, const int* y, int count)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			long column = x[j] - x_origin;
+			long row = (height - 1) - (y[j] - y_origin);
+			if ((column < 0) || (column >= width) || (row < 0) || (row >= height))
+			{
+				continue;
+			}
+			unsigned char* target = pixels + (3 * ((row * width) + column));
+			target[0] = red;
+			target[1] = green;
+			target[2] = blue;
+		}
+	}
+};
+
+/// <summary>
+/// Sink writing one "x y" line per pixel to a stream.
+/// </summary>
+struct file_sink
+{
+	std::ostream& out;
+
+	void emit(const int* x, const int* y, int count)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			out << x[j] << " " << y[j] << "\n";
+		}
+	}
+};
+
+/// <summary>
+/// Pulls every pixel of the generator and hands them to the sink in blocks of LINE_KERNEL_LANES. Only one
+/// block is held at a time.
+/// </summary>
+/// <returns> Number of pixels produced</returns>
+template <typename Generator, typename Sink>
+constexpr long drain(const Generator& pixels, Sink& sink)
+{
+	int lane_x[LINE_KERNEL_LANES] = {};
+	int lane_y[LINE_KERNEL_LANES] = {};
+	int lanes = 0;
+	long total = 0;
+	for (auto it = pixels.begin(); it != pixels.end(); ++it)
+	{
+		struct pixel current = *it;
+		lane_x[lanes] = current.x;
+		lane_y[lanes] = current.y;
+		lanes = lanes + 1;
+		if (lanes == LINE_KERNEL_LANES)
+		{
+			sink.emit(lane_x, lane_y, lanes);
+			total = total + lanes;
+			lanes = 0;
+		}
+	}
+	if (lanes > 0)
+	{
+		sink.emit(lane_x, lane_y, lanes);
+		total = total + lanes;
+	}
+	return total;
+}
+
+/// <summary>
+/// Compile time check of the line and circle generators against the block rasterizers they replace.
+/// </summary>
+constexpr bool pixel_generators_match(long x_final, long y_final, int radius)
+{
+	long expected[2 * 512] = {};
+	long produced[2 * 512] = {};
+	long delta_x = (x_final >= 0) ? x_final : -x_final;
+	long delta_y = (y_final >= 0) ? y_final : -y_final;
+	long major = (delta_x > delta_y) ? delta_x : delta_y;
+
+	struct strided_sink<2, long> line_sink = { expected };
+	rasterize_line(line_sink, 0, 0, x_final, y_final, major / 3, major);
+	struct strided_sink<2, long> line_generated = { produced };
+	long line_count = drain(line_pixels(0, 0, x_final, y_final, major / 3, major), line_generated);
+
+	struct viewport view = { -1024, -1024, 1024, 1024 };
+	struct strided_sink<2, long> circle_sink = { expected + (2 * line_count) };
+	rasterize_circle(circle_sink, 3, -2, radius);
+	struct strided_sink<2, long> circle_generated = { produced + (2 * line_count) };
+	long circle_count = drain(circle_pixels(3, -2, radius, view), circle_generated);
+
+	if ((line_count != (major - (major / 3) + 1)) || ((circle_sink.output - expected) != (2 * (line_count + circle_count))))
+	{
+		return false;
+	}
+	for (long i = 0; i < 2 * (line_count + circle_count); i++)
+	{
+		if (expected[i] != produced[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(pixel_generators_match(7, 3, 0) && pixel_generators_match(-5, 11, 1) &&
+	pixel_generators_match(200, -90, 20) && pixel_generators_match(-150, -150, 35),
+	"pixel generators do not match rasterize_line and rasterize_circle");
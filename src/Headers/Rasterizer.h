@@ -0,0 +1,465 @@
+#pragma once
+#include <climits>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Trace.h"
+
+#define LINE_KERNEL_LANES 8
+#define OCTANT_X_MAJOR 1
+#define OCTANT_X_NEGATIVE 2
+#define OCTANT_Y_NEGATIVE 4
+
+/// \file
+/// Rasterizer core shared by Line, Circle and the vector field programs. Lines and circles are walked by
+/// templates specialized on the octant, so that every direction and mirror is fixed at compile time, and
+/// pixels are handed in blocks to a sink, which decides where they go.
+///
+/// A sink is any type with a member emit(const int* x, const int* y, int count).
+
+/// <summary>
+/// Sink writing the (x, y) of each pixel into preallocated output, Stride elements apart,
+/// e.g. 5 for (x, y, r, g, b) vertices.
+/// </summary>
+template <long Stride, typename T>
+struct strided_sink
+{
+	T* output;
+
+	constexpr void emit(const int* x, const int* y, int count)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			output[Stride * j] = x[j];
+			output[Stride * j + 1] = y[j];
+		}
+		output = output + (Stride * count);
+	}
+};
+
+/// <summary>
+/// Sink appending the (x, y) of each pixel to a vector.
+/// </summary>
+struct offset_sink
+{
+	std::vector<int>& offsets;
+
+	void emit(const int* x, const int* y, int count)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			offsets.push_back(x[j]);
+			offsets.push_back(y[j]);
+		}
+	}
+};
+
+/// <summary>
+/// Reference Bresenham walk, one pixel and one branch per iteration, in the form used by the original
+/// rasterizers. Walks the line from its start and writes the (x, y) of steps first to last (inclusive)
+/// to output, Stride elements apart.
+/// </summary>
+template <long Stride, typename T>
+constexpr void line_scalar(T* output, long x_initial, long y_initial, long x_final, long y_final,
+	long first, long last)
+{
+	long delta_x = ((x_final - x_initial) >= 0) ? (x_final - x_initial) : -(x_final - x_initial);
+	long delta_y = ((y_final - y_initial) >= 0) ? (y_final - y_initial) : -(y_final - y_initial);
+	long increment_x = (x_final < x_initial) ? -1 : 1;
+	long increment_y = (y_final < y_initial) ? -1 : 1;
+	bool x_major = delta_x > delta_y;
+	long major = x_major ? delta_x : delta_y;
+	long minor = x_major ? delta_y : delta_x;
+	long decision = 2 * minor - major;
+	long x = x_initial;
+	long y = y_initial;
+	for (long i = 0; i <= last; i++)
+	{
+		if (i >= first)
+		{
+			output[Stride * (i - first)] = x;
+			output[Stride * (i - first) + 1] = y;
+		}
+		if (decision >= 0)
+		{
+			x = x_major ? x : x + increment_x;
+			y = x_major ? y + increment_y : y;
+			decision = decision + 2 * (minor - major);
+		}
+		else
+		{
+			decision = decision + 2 * minor;
+		}
+		x = x_major ? x + increment_x : x;
+		y = x_major ? y : y + increment_y;
+	}
+}
+
+/// <summary>
+/// Octant of the line from (x_initial, y_initial) to (x_final, y_final), as a combination of
+/// OCTANT_X_MAJOR, OCTANT_X_NEGATIVE and OCTANT_Y_NEGATIVE.
+/// </summary>
+constexpr int line_octant(long x_initial, long y_initial, long x_final, long y_final)
+{
+	long delta_x = ((x_final - x_initial) >= 0) ? (x_final - x_initial) : -(x_final - x_initial);
+	long delta_y = ((y_final - y_initial) >= 0) ? (y_final - y_initial) : -(y_final - y_initial);
+	return ((delta_x > delta_y) ? OCTANT_X_MAJOR : 0) | ((x_final < x_initial) ? OCTANT_X_NEGATIVE : 0) |
+		((y_final < y_initial) ? OCTANT_Y_NEGATIVE : 0);
+}
+
+/// <summary>
+/// Quotient and remainder of (factor * count + offset) / denominator, for 0 <= factor, offset <= denominator
+/// and count >= 0. factor * count is built up one bit of count at a time, so nothing wider than
+/// 2 * denominator is formed and the result is exact even when factor * count does not fit in a long.
+/// </summary>
+constexpr void line_divide(long factor, long count, long offset, long denominator, long& quotient, long& remainder)
+{
+	quotient = 0;
+	remainder = 0;
+	int top = 0;
+	while ((top < 62) && ((count >> (top + 1)) != 0))
+	{
+		top = top + 1;
+	}
+	for (int bit = top; bit >= 0; bit--)
+	{
+		quotient = 2 * quotient;
+		remainder = 2 * remainder;
+		if ((count >> bit) & 1)
+		{
+			remainder = remainder + factor;
+		}
+		// remainder is now below 3 * denominator.
+		while (remainder >= denominator)
+		{
+			quotient = quotient + 1;
+			remainder = remainder - denominator;
+		}
+	}
+	remainder = remainder + offset;
+	while (remainder >= denominator)
+	{
+		quotient = quotient + 1;
+		remainder = remainder - denominator;
+	}
+}
+
+/// <summary>
+/// Multi-pixel line kernel for one octant. Produces the same pixels as line_scalar, LINE_KERNEL_LANES
+/// steps per iteration. The minor axis offset of step k is floor((2 * minor * k + major) / (2 * major)).
+/// It is tracked as a quotient and remainder per block, and each lane adds a per-line constant plus one
+/// compare-and-carry, so the lane loop is fixed-length and branch free for the compiler to vectorize,
+/// with no division. Axis and directions come from Octant, so nothing is chosen per pixel.
+/// The lane arithmetic is done in Lane, see rasterize_line_octant for when int is wide enough.
+/// </summary>
+/// <param name="major"> Length of the line along its major axis, greater than 0</param>
+/// <param name="minor"> Length of the line along its minor axis</param>
+/// <param name="first"> First step along the major axis</param>
+/// <param name="last"> Last step along the major axis</param>
+template <int Octant, typename Lane, typename Sink>
+constexpr void rasterize_line_lanes(Sink& sink, long x_initial, long y_initial, long major, long minor,
+	long first, long last)
+{
+	constexpr bool x_major = (Octant & OCTANT_X_MAJOR) != 0;
+	constexpr int increment_x = (Octant & OCTANT_X_NEGATIVE) ? -1 : 1;
+	constexpr int increment_y = (Octant & OCTANT_Y_NEGATIVE) ? -1 : 1;
+
+	// quotient + remainder / denominator is the minor axis offset of step first. The quotient and remainder
+	// of 2 * minor * j for every lane j, and of one whole block, are fixed for the line.
+	long denominator = 2 * major;
+	long quotient = 0;
+	long remainder = 0;
+	line_divide(2 * minor, first, major, denominator, quotient, remainder);
+	long block_quotient = 0;
+	long block_remainder = 0;
+
+	Lane lane_quotient[LINE_KERNEL_LANES] = {};
+	Lane lane_remainder[LINE_KERNEL_LANES] = {};
+	int lane_x[LINE_KERNEL_LANES] = {};
+	int lane_y[LINE_KERNEL_LANES] = {};
+	for (long j = 0; j < LINE_KERNEL_LANES; j++)
+	{
+		lane_quotient[j] = block_quotient;
+		lane_remainder[j] = block_remainder;
+		// 2 * minor is at most denominator, so one step carries at most once.
+		block_remainder = block_remainder + (2 * minor);
+		block_quotient = block_quotient + ((block_remainder >= denominator) ? 1 : 0);
+		block_remainder = (block_remainder >= denominator) ? (block_remainder - denominator) : block_remainder;
+	}
+	Lane lane_denominator = denominator;
+	Lane lane_x_initial = x_initial;
+	Lane lane_y_initial = y_initial;
+
+	for (long base = first; base <= last; base = base + LINE_KERNEL_LANES)
+	{
+		// Each lane only has to decide whether its fractional part carries into the next pixel.
+		Lane block_base = base;
+		Lane block_minor = quotient;
+		Lane block_fraction = remainder;
+		for (int j = 0; j < LINE_KERNEL_LANES; j++)
+		{
+			Lane major_offset = block_base + j;
+			Lane minor_offset = block_minor + lane_quotient[j] + (((block_fraction + lane_remainder[j]) >= lane_denominator) ? 1 : 0);
+			// Pixels the sink is given lie on the canvas, so their coordinates fit in an int.
+			lane_x[j] = lane_x_initial + (increment_x * (x_major ? major_offset : minor_offset));
+			lane_y[j] = lane_y_initial + (increment_y * (x_major ? minor_offset : major_offset));
+		}
+
+		if ((last - base + 1) >= LINE_KERNEL_LANES)
+		{
+			sink.emit(lane_x, lane_y, LINE_KERNEL_LANES);
+		}
+		else
+		{
+			sink.emit(lane_x, lane_y, last - base + 1);
+		}
+
+		remainder = remainder + block_remainder;
+		quotient = quotient + block_quotient + ((remainder >= denominator) ? 1 : 0);
+		remainder = (remainder >= denominator) ? (remainder - denominator) : remainder;
+	}
+}
+
+/// <summary>
+/// Walks steps first to last (inclusive) of a line in one octant with rasterize_line_lanes. The lanes are
+/// 32 bit, so that they fill a vector register, whenever every intermediate fits in an int: the remainders
+/// stay below 2 * denominator = 4 * major, and the offsets below last + LINE_KERNEL_LANES. Longer lines
+/// walk the same kernel with 64 bit lanes.
+/// </summary>
+template <int Octant, typename Sink>
+constexpr void rasterize_line_octant(Sink& sink, long x_initial, long y_initial, long major, long minor,
+	long first, long last)
+{
+	long reach = last + LINE_KERNEL_LANES + 1;
+	long x_reach = ((x_initial >= 0) ? x_initial : -x_initial) + reach;
+	long y_reach = ((y_initial >= 0) ? y_initial : -y_initial) + reach;
+	if ((major <= (INT_MAX / 4)) && (x_reach <= INT_MAX) && (y_reach <= INT_MAX))
+	{
+		rasterize_line_lanes<Octant, int>(sink, x_initial, y_initial, major, minor, first, last);
+	}
+	else
+	{
+		rasterize_line_lanes<Octant, long>(sink, x_initial, y_initial, major, minor, first, last);
+	}
+}
+
+/// <summary>
+/// Rasterizes steps first to last (inclusive) of the Bresenham line from (x_initial, y_initial) to
+/// (x_final, y_final) into the sink. The octant is picked once here, and the walk itself runs in the
+/// rasterize_line_octant specialization for it.
+/// </summary>
+/// <param name="first"> First step along the major axis</param>
+/// <param name="last"> Last step along the major axis</param>
+template <typename Sink>
+constexpr void rasterize_line(Sink& sink, long x_initial, long y_initial, long x_final, long y_final,
+	long first, long last)
+{
+	long delta_x = ((x_final - x_initial) >= 0) ? (x_final - x_initial) : -(x_final - x_initial);
+	long delta_y = ((y_final - y_initial) >= 0) ? (y_final - y_initial) : -(y_final - y_initial);
+	long major = (delta_x > delta_y) ? delta_x : delta_y;
+	long minor = (delta_x > delta_y) ? delta_y : delta_x;
+	if (major == 0)
+	{
+		int x = x_initial;
+		int y = y_initial;
+		sink.emit(&x, &y, 1);
+		return;
+	}
+
+	switch (line_octant(x_initial, y_initial, x_final, y_final))
+	{
+	case 0:
+		rasterize_line_octant<0>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	case 1:
+		rasterize_line_octant<1>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	case 2:
+		rasterize_line_octant<2>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	case 3:
+		rasterize_line_octant<3>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	case 4:
+		rasterize_line_octant<4>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	case 5:
+		rasterize_line_octant<5>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	case 6:
+		rasterize_line_octant<6>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	default:
+		rasterize_line_octant<7>(sink, x_initial, y_initial, major, minor, first, last);
+		break;
+	}
+}
+
+/// <summary>
+/// Offset of the point mirrored into the given octant from the point (x, y) of the first octant of a circle.
+/// Octants 0 to 3 keep the axes and 4 to 7 swap them; bit 0 negates x and bit 1 negates y, which is the
+/// order the original midpoint code pushed them in.
+/// </summary>
+template <int Octant>
+constexpr int circle_octant_x(int x, int y)
+{
+	return ((Octant & 1) ? -1 : 1) * ((Octant >= 4) ? y : x);
+}
+
+template <int Octant>
+constexpr int circle_octant_y(int x, int y)
+{
+	return ((Octant & 2) ? -1 : 1) * ((Octant >= 4) ? x : y);
+}
+
+template <typename Sink, int... Octant>
+constexpr void circle_emit_octants(Sink& sink, int x_center, int y_center, int x, int y,
+	std::integer_sequence<int, Octant...>)
+{
+	int lane_x[] = { (x_center + circle_octant_x<Octant>(x, y))... };
+	int lane_y[] = { (y_center + circle_octant_y<Octant>(x, y))... };
+	sink.emit(lane_x, lane_y, sizeof...(Octant));
+}
+
+/// <summary>
+/// Midpoint circle. Walks the first octant and hands the mirrored points of every step to the sink at once,
+/// as one block of 8 lanes. On the octant boundaries (x == 0 and x == y) pairs of mirrors coincide, so only
+/// the distinct ones are emitted there and every pixel of the circle appears exactly once.
+/// </summary>
+template <typename Sink>
+constexpr void rasterize_circle(Sink& sink, int x_center, int y_center, int radius)
+{
+	int decision = 1 - radius;
+	int increment_east = 3;
+	int increment_southeast = (-2 * radius) + 5;
+	int x = 0;
+	int y = radius;
+	while (y >= x)
+	{
+		if ((x == 0) && (y == 0))
+		{
+			circle_emit_octants(sink, x_center, y_center, x, y, std::integer_sequence<int, 0>());
+		}
+		else if (x == 0)
+		{
+			circle_emit_octants(sink, x_center, y_center, x, y, std::integer_sequence<int, 0, 2, 4, 5>());
+		}
+		else if (x == y)
+		{
+			circle_emit_octants(sink, x_center, y_center, x, y, std::integer_sequence<int, 0, 1, 2, 3>());
+		}
+		else
+		{
+			circle_emit_octants(sink, x_center, y_center, x, y, std::make_integer_sequence<int, 8>());
+		}
+
+		if (decision < 0)
+		{
+			decision = decision + increment_east;
+			increment_east = increment_east + 2;
+			increment_southeast = increment_southeast + 2;
+		}
+		else
+		{
+			decision = decision + increment_southeast;
+			increment_east = increment_east + 2;
+			increment_southeast = increment_southeast + 4;
+			y = y - 1;
+		}
+		x = x + 1;
+	}
+}
+
+/// <summary>
+/// Least recently used cache of circle stencils: the (x, y) offsets from the center of every point of a
+/// circle, in the order rasterize_circle generates them. A stencil is computed once per radius and then
+/// reused until capacity other radii have been requested.
+/// </summary>
+class CircleStencilCache
+{
+public:
+	explicit CircleStencilCache(size_t capacity) : capacity(capacity)
+	{
+	}
+
+	const std::vector<int>& lookup(int radius)
+	{
+		auto found = index.find(radius);
+		if (found != index.end())
+		{
+			stencils.splice(stencils.begin(), stencils, found->second);
+			return stencils.front().second;
+		}
+
+		std::vector<int> offsets;
+		{
+			TRACE_ZONE("midpoint circle");
+			struct offset_sink sink = { offsets };
+			rasterize_circle(sink, 0, 0, radius);
+		}
+
+		if (stencils.size() >= capacity)
+		{
+			index.erase(stencils.back().first);
+			stencils.pop_back();
+		}
+		stencils.emplace_front(radius, std::move(offsets));
+		index[radius] = stencils.begin();
+		return stencils.front().second;
+	}
+
+private:
+	size_t capacity;
+	// Most recently used first; index maps a radius to its entry.
+	std::list<std::pair<int, std::vector<int>>> stencils;
+	std::unordered_map<int, std::list<std::pair<int, std::vector<int>>>::iterator> index;
+};
+
+/// <summary>
+/// Compile time check of rasterize_line against line_scalar for a line from the origin, both for the whole
+/// line and for a range starting part way along it.
+/// </summary>
+constexpr bool rasterize_line_matches_scalar(long x_final, long y_final)
+{
+	long kernel[2 * 512] = {};
+	long scalar[2 * 512] = {};
+	long delta_x = (x_final >= 0) ? x_final : -x_final;
+	long delta_y = (y_final >= 0) ? y_final : -y_final;
+	long major = (delta_x > delta_y) ? delta_x : delta_y;
+	long starts[2] = { 0, major / 3 };
+	for (long s = 0; s < 2; s++)
+	{
+		struct strided_sink<2, long> sink = { kernel };
+		rasterize_line(sink, 0, 0, x_final, y_final, starts[s], major);
+		line_scalar<2>(scalar, 0, 0, x_final, y_final, starts[s], major);
+		for (long i = 0; i < 2 * (major - starts[s] + 1); i++)
+		{
+			if (kernel[i] != scalar[i])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+constexpr bool rasterize_line_self_test()
+{
+	for (long x = -12; x <= 12; x++)
+	{
+		for (long y = -12; y <= 12; y++)
+		{
+			if (!rasterize_line_matches_scalar(x, y))
+			{
+				return false;
+			}
+		}
+	}
+	return rasterize_line_matches_scalar(511, 173) && rasterize_line_matches_scalar(-300, 299) &&
+		rasterize_line_matches_scalar(97, -511) && rasterize_line_matches_scalar(-400, -400);
+}
+
+static_assert(rasterize_line_self_test(), "rasterize_line does not match the scalar Bresenham walk");
@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "FrameCache.h"
+
+/// \file
+/// Event driven redraw. Instead of clearing and drawing every frame, the window sleeps in glfwWaitEvents()
+/// and only presents when it was exposed, resized or its data changed. The plot is kept in a frame_cache,
+/// so an expose only draws the cached texture again and a data change only redraws the primitives in the
+/// dirty ranges on top of the cached image.
+
+/// <summary>
+/// What has to be redrawn before the next present. Data changes may be marked from any thread.
+/// </summary>
+struct redraw_state
+{
+	std::mutex lock;
+	bool expose = true;
+	bool full = false;
+	std::vector<std::pair<long, long>> ranges;
+};
+
+/// <summary>
+/// Marks the whole plot dirty and wakes up the event loop.
+/// </summary>
+inline void redraw_mark_all(struct redraw_state& state)
+{
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+		state.full = true;
+	}
+	glfwPostEmptyEvent();
+}
+
+/// <summary>
+/// Marks count primitives starting at first dirty and wakes up the event loop. Only those primitives are
+/// drawn again, over the previous image, so this suits updates that keep their positions (e.g. new colors).
+/// Primitives that moved leave their old pixels behind; use redraw_mark_all() for those.
+/// </summary>
+inline void redraw_mark_range(struct redraw_state& state, long first, long count)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+		state.ranges.push_back(std::make_pair(first, first + count));
+	}
+	glfwPostEmptyEvent();
+}
+
+/// <summary>
+/// Marks the window to be presented again, from the cache, without drawing any primitives. Does not wake up
+/// the event loop, so this is meant for the thread running it.
+/// </summary>
+inline void redraw_mark_expose(struct redraw_state& state)
+{
+	std::lock_guard<std::mutex> guard(state.lock);
+	state.expose = true;
+}
+
+inline void redraw_refresh_callback(GLFWwindow* window)
+{
+	redraw_mark_expose(*static_cast<struct redraw_state*>(glfwGetWindowUserPointer(window)));
+}
+
+inline void redraw_framebuffer_size_callback(GLFWwindow* window, int /* width */, int /* height */)
+{
+	// redraw_present() notices the new size itself and rebuilds the cache.
+	redraw_refresh_callback(window);
+}
+
+/// <summary>
+/// Installs the expose and resize callbacks of the window. The state must outlive the window.
+/// </summary>
+inline void redraw_attach(GLFWwindow* window, struct redraw_state& state)
+{
+	glfwSetWindowUserPointer(window, &state);
+	glfwSetWindowRefreshCallback(window, redraw_refresh_callback);
+	glfwSetFramebufferSizeCallback(window, redraw_framebuffer_size_callback);
+}
+
+/// <summary>
+/// Brings the back buffer up to date with whatever was marked since the last call.
+/// </summary>
+/// <param name="cached"> Whether cache holds the plot; cleared if the cache cannot be rebuilt after a resize</param>
+/// <param name="count"> Number of primitives in the plot</param>
+/// <param name="draw"> draw(first, count) draws count primitives starting at first</param>
+/// <returns> true if something was drawn and the buffers should be swapped</returns>
+template <typename Draw>
+inline bool redraw_present(struct redraw_state& state, GLFWwindow* window, struct frame_cache& cache, bool& cached,
+	long count, Draw draw)
+{
+	bool expose;
+	bool full;
+	std::vector<std::pair<long, long>> ranges;
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+		expose = state.expose;
+		full = state.full;
+		ranges.swap(state.ranges);
+		state.expose = false;
+		state.full = false;
+	}
+	if (!expose && !full && ranges.empty())
+	{
+		return false;
+	}
+
+	int width;
+	int height;
+	glfwGetFramebufferSize(window, &width, &height);
+	if ((width == 0) || (height == 0))
+	{
+		// Minimized. Restoring the window sends a refresh, and the cache still holds the plot.
+		return false;
+	}
+	if (cached && ((cache.width != width) || (cache.height != height)))
+	{
+		frame_cache_destroy(cache);
+		cached = frame_cache_create(cache, width, height);
+		full = true;
+	}
+	glViewport(0, 0, width, height);
+
+	if (!cached)
+	{
+		// The back buffer is undefined after a swap, so without the cache every present is a full redraw.
+		glClear(GL_COLOR_BUFFER_BIT);
+		draw(0, count);
+		return true;
+	}
+
+	if (full)
+	{
+		frame_cache_begin(cache);
+		draw(0, count);
+		frame_cache_end(width, height);
+	}
+	else if (!ranges.empty())
+	{
+		// Merge overlapping and adjacent ranges, so that no primitive is drawn twice.
+		std::sort(ranges.begin(), ranges.end());
+		frame_cache_begin(cache, false);
+		long begin = ranges[0].first;
+		long end = ranges[0].second;
+		for (size_t i = 1; i <= ranges.size(); i++)
+		{
+			if ((i < ranges.size()) && (ranges[i].first <= end))
+			{
+				end = std::max(end, ranges[i].second);
+				continue;
+			}
+			begin = std::max(begin, 0l);
+			end = std::min(end, count);
+			if (begin < end)
+			{
+				draw(begin, end - begin);
+			}
+			if (i < ranges.size())
+			{
+				begin = ranges[i].first;
+				end = ranges[i].second;
+			}
+		}
+		frame_cache_end(width, height);
+	}
+
+	glClear(GL_COLOR_BUFFER_BIT);
+	frame_cache_draw(cache);
+	return true;
+}
@@ -0,0 +1,414 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Clipping.h"
+#include "Rasterizer.h"
+#include "Arrowhead.h"
+#include "PixelGenerators.h"
+#include "MemoryStats.h"
+#include "Arena.h"
+
+#define RENDER_JOB_FIELD 0
+#define RENDER_JOB_POLYLINE 1
+
+#define RENDER_FIELD_REDUCTION_FACTOR 25
+#define RENDER_FIELD_SCALING_FACTOR 100000000
+#define RENDER_FIELD_FIXED_MAX_SIDE 8192
+#define RENDER_POLYLINE_SCALING_FACTOR 35
+#define RENDER_ORBIT_HISTORY 16
+#define RENDER_SIMILARITY_THRESHOLD 50
+#define RENDER_LENGTH_SPLIT 4
+#define RENDER_WIDTH_SPLIT 4
+
+/// \file
+/// Reentrant rendering of the vector field programs. The canvas size, the random engine and the basepoints
+/// live in a render_context, so any number of renders can run at the same time on different threads. The
+/// line and polyline programs lay out, shade and step their fields with the functions here, and a render
+/// paints an RGB framebuffer, stored from its top row down, with the pixels and colors those programs draw
+/// for the same canvas and seed.
+
+/// <summary>
+/// Corner color of the canvas, fading out over dropoff pixels.
+/// </summary>
+struct render_basepoint
+{
+	uint64_t length;
+	uint64_t width;
+	int16_t red;
+	int16_t green;
+	int16_t blue;
+	double dropoff;
+};
+
+/// <summary>
+/// State of one render. Every function taking a context only touches that context.
+/// </summary>
+struct render_context
+{
+	long window_width;
+	long window_height;
+	std::mt19937 engine;
+	counted_vector<struct render_basepoint, basepoint_memory> basepoints;
+};
+
+/// <summary>
+/// What to render: RENDER_JOB_FIELD draws the whole vector field, RENDER_JOB_POLYLINE draws up to total
+/// steps of the polyline starting at (x_start, y_start). Jobs with equal fields give equal images.
+/// </summary>
+struct render_job
+{
+	int kind;
+	long width;
+	long height;
+	unsigned int seed;
+	long x_start;
+	long y_start;
+	long total;
+};
+
+/// <summary>
+/// Canonical text of the job, equal for two jobs exactly when they render the same image.
+/// </summary>
+inline std::string render_job_key(const struct render_job& job)
+{
+	std::ostringstream key;
+	key << job.kind << " " << job.width << " " << job.height << " " << job.seed;
+	if (job.kind == RENDER_JOB_POLYLINE)
+	{
+		key << " " << job.x_start << " " << job.y_start << " " << job.total;
+	}
+	return key.str();
+}
+
+inline double render_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2)
+{
+	uint64_t dlength = std::max(length1, length2) - std::min(length1, length2);
+	uint64_t dwidth = std::max(width1, width2) - std::min(width1, width2);
+	return std::pow(std::pow(dlength, 2) + std::pow(dwidth, 2), 0.5);
+}
+
+inline int16_t render_verifybounds_int16_t(int16_t check)
+{
+	return (check > 0) ? check : 0;
+}
+
+/// <summary>
+/// Random basepoint inside the given range of the canvas, drawn from the context's engine in the same
+/// order as the programs draw it from theirs.
+/// </summary>
+inline struct render_basepoint render_basepoint_layout_helper(struct render_context& context, uint64_t length_l,
+	uint64_t length_r, uint64_t width_u, uint64_t width_d)
+{
+	long extent = std::max(context.window_width, context.window_height);
+	std::uniform_int_distribution<uint64_t> rand_length(length_l, length_r);
+	std::uniform_int_distribution<uint64_t> rand_width(width_u, width_d);
+	std::uniform_int_distribution<uint16_t> rand_red(127, 255);
+	std::uniform_int_distribution<uint16_t> rand_green(127, 255);
+	std::uniform_int_distribution<uint16_t> rand_blue(127, 255);
+	std::uniform_real_distribution<double> rand_dropoff(3 * extent / 4, extent);
+
+	struct render_basepoint temp;
+	temp.length = rand_length(context.engine);
+	context.engine.discard(temp.length);
+	temp.width = rand_width(context.engine);
+	context.engine.discard(temp.width);
+	temp.red = rand_red(context.engine);
+	context.engine.discard(temp.red);
+	temp.green = rand_green(context.engine);
+	context.engine.discard(temp.green);
+	temp.blue = rand_blue(context.engine);
+	context.engine.discard(temp.blue);
+	temp.dropoff = rand_dropoff(context.engine);
+	context.engine.discard(extent);
+
+	for (size_t i = 0; i < context.basepoints.size(); i++)
+	{
+		const struct render_basepoint& other = context.basepoints[i];
+		if ((std::abs(temp.red - other.red) < RENDER_SIMILARITY_THRESHOLD) && (std::abs(temp.green - other.green) < RENDER_SIMILARITY_THRESHOLD) &&
+			(std::abs(temp.blue - other.blue) < RENDER_SIMILARITY_THRESHOLD))
+		{
+			temp = render_basepoint_layout_helper(context, length_l, length_r, width_u, width_d);
+		}
+	}
+	return temp;
+}
+
+/// <summary>
+/// Sets the context up for a width x height canvas: seeds its engine and places one basepoint in every
+/// corner of the canvas.
+/// </summary>
+inline void render_context_create(struct render_context& context, long width, long height, unsigned int seed)
+{
+	context.window_width = width;
+	context.window_height = height;
+	context.engine.seed(seed);
+	context.basepoints.clear();
+
+	uint64_t left = width / RENDER_LENGTH_SPLIT;
+	uint64_t right = width - (width / RENDER_LENGTH_SPLIT);
+	uint64_t bottom = height / RENDER_WIDTH_SPLIT;
+	uint64_t top = height - (height / RENDER_WIDTH_SPLIT);
+	context.basepoints.push_back(render_basepoint_layout_helper(context, 0, left, 0, bottom));
+	context.basepoints.push_back(render_basepoint_layout_helper(context, right, width, 0, bottom));
+	context.basepoints.push_back(render_basepoint_layout_helper(context, 0, left, top, height));
+	context.basepoints.push_back(render_basepoint_layout_helper(context, right, width, top, height));
+}
+
+/// <summary>
+/// Color of the vertex at position (x, y), blended from the basepoints of the context, as the programs store
+/// it. Only reads the context, so vertices can be shaded from several threads at once.
+/// </summary>
+/// <param name="position"> (x, y) of the vertex, with the origin at the center of the canvas</param>
+/// <param name="color"> (r, g, b) of the vertex, each in [0, 1]</param>
+inline void render_shade_vertex(const struct render_context& context, const float* position, float* color)
+{
+	int16_t red = 0;
+	int16_t green = 0;
+	int16_t blue = 0;
+	uint64_t x_coordinate = position[0] + (context.window_width / 2);
+	uint64_t y_coordinate = position[1] + (context.window_height / 2);
+	for (size_t i = 0; i < context.basepoints.size(); i++)
+	{
+		const struct render_basepoint& base = context.basepoints[i];
+		if ((base.length == x_coordinate) && (base.width == y_coordinate))
+		{
+			red = base.red;
+			green = base.green;
+			blue = base.blue;
+			break;
+		}
+		double falloff = 1.0 - ((1.0 / base.dropoff) * render_absdistance(x_coordinate, y_coordinate, base.length, base.width));
+		red = red + render_verifybounds_int16_t((double)base.red * falloff);
+		green = green + render_verifybounds_int16_t((double)base.green * falloff);
+		blue = blue + render_verifybounds_int16_t((double)base.blue * falloff);
+	}
+	color[0] = std::min<int16_t>(red, 255) / 255.0f;
+	color[1] = std::min<int16_t>(green, 255) / 255.0f;
+	color[2] = std::min<int16_t>(blue, 255) / 255.0f;
+}
+
+/// <summary>
+/// Color of the pixel at (x, y) as stored in an image: the vertex color quantized to bytes.
+/// </summary>
+inline void render_shade(const struct render_context& context, float x, float y, unsigned char* rgb)
+{
+	float position[2] = { x, y };
+	float color[3];
+	render_shade_vertex(context, position, color);
+	rgb[0] = (unsigned char)((color[0] * 255.0f) + 0.5f);
+	rgb[1] = (unsigned char)((color[1] * 255.0f) + 0.5f);
+	rgb[2] = (unsigned char)((color[2] * 255.0f) + 0.5f);
+}
+
+/// <summary>
+/// Vector field of the line program at (x, y), in floating point so that it cannot overflow.
+/// </summary>
+inline void render_field_value(long x, long y, double& x_vector, double& y_vector)
+{
+	x_vector = (double)x * x * x * x * y;
+	y_vector = (double)y * y * y * y * x;
+}
+
+/// <summary>
+/// Arrow of the line program at the grid point (x, y) with its fixed glyph scale, in pixels.
+/// </summary>
+/// @warning x^4 * y is taken in long, which only holds for |x|, |y| <= 4096: canvases up to
+/// RENDER_FIELD_FIXED_MAX_SIDE on each side.
+inline void render_field_vector(long x, long y, long& x_vector, long& y_vector)
+{
+	x_vector = (x * x * x * x * y) / RENDER_FIELD_SCALING_FACTOR;
+	y_vector = (y * y * y * y * x) / RENDER_FIELD_SCALING_FACTOR;
+}
+
+/// <summary>
+/// Displacement of one step of the polyline program starting at (x, y), in pixels.
+/// </summary>
+constexpr void render_polyline_step(long x, long y, long& x_vector, long& y_vector)
+{
+	x_vector = (x * x) / RENDER_POLYLINE_SCALING_FACTOR;
+	y_vector = y / RENDER_POLYLINE_SCALING_FACTOR;
+}
+
+/// <summary>
+/// Sink shading every pixel with the context and painting it into the framebuffer of the canvas.
+/// </summary>
+struct render_sink
+{
+	const struct render_context& context;
+	unsigned char* pixels;
+
+	void emit(const int* x, const int* y, int count)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			long column = x[j] + (context.window_width / 2);
+			long row = (context.window_height - 1) - (y[j] + (context.window_height / 2));
+			render_shade(context, (float)x[j], (float)y[j], pixels + (3 * ((row * context.window_width) + column)));
+		}
+	}
+};
+
+/// <summary>
+/// Pixels of the framebuffer: the window of the programs, without the column and row at +width / 2 and
+/// +height / 2 that have no place in a width x height image.
+/// </summary>
+inline struct viewport render_viewport(const struct render_context& context)
+{
+	struct viewport view = { -(context.window_width / 2), -(context.window_height / 2),
+		context.window_width - (context.window_width / 2) - 1, context.window_height - (context.window_height / 2) - 1 };
+	return view;
+}
+
+/// <summary>
+/// Draws the arrow from (x, y) along (x_vector, y_vector) into the framebuffer.
+/// </summary>
+inline void render_arrow(const struct render_context& context, unsigned char* pixels, long x, long y, long x_vector, long y_vector)
+{
+	const struct arrowhead_stamp& stamp = arrowhead_stamp_for(x_vector, y_vector);
+	struct render_sink sink = { context, pixels };
+	drain(arrow_pixels(render_viewport(context), x, y, x + x_vector, y + y_vector, stamp.offsets, stamp.count), sink);
+}
+
+/// <summary>
+/// Draws the vector field of the line program, with its fixed glyph scale, into pixels.
+/// </summary>
+/// <param name="pixels"> 3 * width * height bytes, cleared by the caller</param>
+inline void render_field(const struct render_context& context, unsigned char* pixels)
+{
+	long half_width = context.window_width / 2;
+	long half_height = context.window_height / 2;
+	for (long x = -half_width; x < half_width; x = x + RENDER_FIELD_REDUCTION_FACTOR)
+	{
+		for (long y = -half_height; y < half_height; y = y + RENDER_FIELD_REDUCTION_FACTOR)
+		{
+			long x_vector;
+			long y_vector;
+			render_field_vector(x, y, x_vector, y_vector);
+			render_arrow(context, pixels, x, y, x_vector, y_vector);
+		}
+	}
+}
+
+/// <summary>
+/// Integrates up to total steps of the polyline starting at (x_start, y_start) and calls
+/// step(x, y, x_vector, y_vector) for each of them. Stops early once the polyline leaves the canvas, stalls at
+/// a fixed point or revisits one of its last RENDER_ORBIT_HISTORY points, since every later step would only
+/// repeat or be invisible.
+/// A start close enough to the origin stalls on its first step, so the walk may take no steps at all.
+/// </summary>
+/// <param name="step"> Callable taking (long x, long y, long x_vector, long y_vector)</param>
+/// <param name="stop_reason"> Why the polyline stopped early, or NULL if it took all total steps</param>
+/// <returns> Number of steps taken</returns>
+template <typename Step>
+constexpr long render_polyline_walk(long window_width, long window_height, long x_start, long y_start, long total, Step step,
+	const char*& stop_reason)
+{
+	long x_history[RENDER_ORBIT_HISTORY] = {};
+	long y_history[RENDER_ORBIT_HISTORY] = {};
+	stop_reason = NULL;
+	long steps = 0;
+	for (; steps < total; steps++)
+	{
+		if ((x_start > (window_width / 2)) || (x_start < -(window_width / 2)) ||
+			(y_start > (window_height / 2)) || (y_start < -(window_height / 2)))
+		{
+			stop_reason = "it left the window";
+			break;
+		}
+		long x_vector = 0;
+		long y_vector = 0;
+		render_polyline_step(x_start, y_start, x_vector, y_vector);
+		if ((x_vector == 0) && (y_vector == 0))
+		{
+			stop_reason = "it stalled at a fixed point";
+			break;
+		}
+		for (long k = 0; k < std::min(steps, (long)RENDER_ORBIT_HISTORY); k++)
+		{
+			if ((x_history[k] == x_start) && (y_history[k] == y_start))
+			{
+				stop_reason = "it entered a cycle";
+			}
+		}
+		if (stop_reason != NULL)
+		{
+			break;
+		}
+		x_history[steps % RENDER_ORBIT_HISTORY] = x_start;
+		y_history[steps % RENDER_ORBIT_HISTORY] = y_start;
+
+		step(x_start, y_start, x_vector, y_vector);
+		x_start = x_start + x_vector;
+		y_start = y_start + y_vector;
+	}
+	return steps;
+}
+
+template <typename Step>
+long render_polyline_walk(const struct render_context& context, long x_start, long y_start, long total, Step step,
+	const char*& stop_reason)
+{
+	return render_polyline_walk(context.window_width, context.window_height, x_start, y_start, total, step, stop_reason);
+}
+
+/// <summary>
+/// Compile time check of render_polyline_walk on an 800 x 600 canvas. From (3, 3) both components of the
+/// first step round to 0, so the walk stops at once without calling step; from (100, 100) it draws before it
+/// leaves the window.
+/// </summary>
+constexpr bool render_polyline_walk_self_test()
+{
+	long stalled = 0;
+	long moving = 0;
+	const char* stalled_reason = NULL;
+	const char* moving_reason = NULL;
+	long stalled_steps = render_polyline_walk(800, 600, 3, 3, 100, [&stalled](long, long, long, long) { stalled = stalled + 1; }, stalled_reason);
+	long moving_steps = render_polyline_walk(800, 600, 100, 100, 100, [&moving](long, long, long, long) { moving = moving + 1; }, moving_reason);
+	return (stalled_steps == 0) && (stalled == 0) && (stalled_reason != NULL) &&
+		(moving_steps > 0) && (moving == moving_steps) && (moving_reason != NULL);
+}
+
+static_assert(render_polyline_walk_self_test(), "render_polyline_walk does not stop on a polyline that stalls on its first step");
+
+/// <summary>
+/// Draws the polyline of the polyline program into pixels.
+/// </summary>
+/// <param name="pixels"> 3 * width * height bytes, cleared by the caller</param>
+/// <returns> Number of steps drawn</returns>
+inline long render_polyline(const struct render_context& context, unsigned char* pixels, long x_start, long y_start, long total)
+{
+	const char* stop_reason;
+	return render_polyline_walk(context, x_start, y_start, total, [&context, pixels](long x, long y, long x_vector, long y_vector)
+	{
+		render_arrow(context, pixels, x, y, x_vector, y_vector);
+	}, stop_reason);
+}
+
+/// <summary>
+/// Runs the job in a context of its own.
+/// </summary>
+/// <param name="lane"> Lane of arena the image is allocated from, not used by any other thread meanwhile</param>
+/// <returns> The 3 * width * height bytes of the image, valid until arena is reset</returns>
+inline struct slice<unsigned char> render_job_run(const struct render_job& job, Arena& arena, long lane = 0)
+{
+	struct render_context context;
+	render_context_create(context, job.width, job.height, job.seed);
+	struct slice<unsigned char> pixels = arena.allocate<unsigned char>(3 * job.width * job.height, lane);
+	std::memset(pixels.data, 0, pixels.count);
+	if (job.kind == RENDER_JOB_POLYLINE)
+	{
+		render_polyline(context, pixels.data, job.x_start, job.y_start, job.total);
+	}
+	else
+	{
+		render_field(context, pixels.data);
+	}
+	return pixels;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <iostream>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "FrameCache.h"
+#include "Redraw.h"
+#include "FrameStats.h"
+#include "FrameOverlay.h"
+
+/// \file
+/// The window loop shared by the programs, once their points are uploaded and their program is bound.
+
+/// <summary>
+/// Toggles of the window loop, usually the STATIC_PLOT, EVENT_DRIVEN_REDRAW, FRAME_STATS and
+/// FRAME_STATS_OVERLAY defines of the program. With event_driven_redraw, redraw may point to a state owned
+/// by the program, so that other threads can mark data changes in it while the loop runs; when it is NULL
+/// the loop keeps its own.
+/// </summary>
+struct render_loop_options
+{
+	bool static_plot;
+	bool event_driven_redraw;
+	bool frame_stats;
+	bool frame_stats_overlay;
+	struct redraw_state* redraw;
+};
+
+/// <summary>
+/// Presents the plot until the window is closed.
+/// With static_plot the plot is drawn once into a texture, and every frame only draws that texture.
+/// event_driven_redraw keeps the texture too, and only presents when the window was exposed or resized, or
+/// when a range of the plot was marked dirty, see Redraw.h.
+/// With frame_stats every frame is timed on the CPU and, through timer queries, on the GPU, and the
+/// percentiles are printed when the window is closed. frame_stats_overlay also draws the numbers in the top
+/// left corner of the window, see FrameOverlay.h; with event_driven_redraw the window is then also presented
+/// once every FRAME_STATS_OVERLAY_SECONDS to refresh them.
+/// </summary>
+/// <param name="points"> Number of points or arrows in the plot, reported by the frame stats</param>
+/// <param name="draw"> draw(first, count) draws count points or arrows starting at first; draw(0, points) draws
+/// the whole plot</param>
+template <typename Draw>
+void render_loop(GLFWwindow* window, long points, Draw draw, const struct render_loop_options& options)
+{
+	int framebuffer_width;
+	int framebuffer_height;
+	glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+	struct frame_cache cache;
+	bool cached = (options.static_plot || options.event_driven_redraw) && frame_cache_create(cache, framebuffer_width, framebuffer_height);
+	if (cached)
+	{
+		frame_cache_begin(cache);
+		draw(0, points);
+		frame_cache_end(framebuffer_width, framebuffer_height);
+	}
+
+	struct redraw_state own_redraw;
+	struct redraw_state& redraw = (options.redraw != NULL) ? *options.redraw : own_redraw;
+	if (options.event_driven_redraw)
+	{
+		redraw_attach(window, redraw);
+	}
+
+	struct frame_stats stats;
+	if (options.frame_stats)
+	{
+		frame_stats_create(stats);
+	}
+	struct frame_overlay overlay;
+	bool overlaid = options.frame_stats && options.frame_stats_overlay && frame_overlay_create(overlay);
+
+	while (!glfwWindowShouldClose(window))
+	{
+		if (options.frame_stats)
+		{
+			frame_stats_begin(stats);
+		}
+
+		bool presented = true;
+		if (options.event_driven_redraw)
+		{
+			if (overlaid && frame_overlay_due(stats))
+			{
+				// The numbers on screen only change when the window is presented.
+				redraw_mark_expose(redraw);
+			}
+			presented = redraw_present(redraw, window, cache, cached, points, draw);
+		}
+		else
+		{
+			glClear(GL_COLOR_BUFFER_BIT);
+			if (cached)
+			{
+				frame_cache_draw(cache);
+			}
+			else
+			{
+				draw(0, points);
+			}
+		}
+
+		if (presented && overlaid)
+		{
+			// Drawn over the finished plot, never into the frame cache.
+			frame_overlay_update(overlay, stats);
+			glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+			frame_overlay_draw(overlay, framebuffer_width, framebuffer_height);
+		}
+		if (presented)
+		{
+			glfwSwapBuffers(window);
+		}
+		if (options.frame_stats)
+		{
+			if (presented)
+			{
+				frame_stats_end(stats, points);
+			}
+			else
+			{
+				frame_stats_cancel(stats);
+			}
+		}
+
+		if (options.event_driven_redraw && overlaid)
+		{
+			glfwWaitEventsTimeout(FRAME_STATS_OVERLAY_SECONDS);
+		}
+		else if (options.event_driven_redraw)
+		{
+			glfwWaitEvents();
+		}
+		else
+		{
+			glfwPollEvents();
+		}
+	}
+
+	if (options.frame_stats)
+	{
+		frame_stats_report(stats, std::cout);
+		frame_stats_destroy(stats);
+	}
+	if (overlaid)
+	{
+		frame_overlay_destroy(overlay);
+	}
+	if (cached)
+	{
+		frame_cache_destroy(cache);
+	}
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+#define TRACE_BUFFER_RESERVE 4096
+
+/// \file
+/// Scoped trace zones and counters, written out as Chrome trace JSON that chrome://tracing and Perfetto
+/// load directly. Everything is compiled out unless TRACE_ENABLED is 1, e.g. with -DTRACE_ENABLED=1:
+/// the macros then expand to nothing and the stages pay no cost at all.
+///
+/// TRACE_ZONE(name) times the enclosing scope, TRACE_COUNTER(name, amount) adds amount to a counter and
+/// TRACE_DUMP(filename) writes everything recorded so far. Names must be string literals. Every thread
+/// records into a buffer of its own, so recording takes no lock; only the first event of a thread does.
+
+/// <summary>
+/// Finished zone ('X', value is its duration) or counter increment ('C', value is the amount), with times
+/// in nanoseconds.
+/// </summary>
+struct trace_event
+{
+	const char* name;
+	char phase;
+	long long start;
+	long long value;
+};
+
+/// <summary>
+/// Events of one thread, in the order they were recorded. Owned by the registry, so that the events of a
+/// worker outlive the worker.
+/// </summary>
+struct trace_buffer
+{
+	long thread;
+	std::vector<struct trace_event> events;
+};
+
+struct trace_registry
+{
+	std::mutex lock;
+	std::vector<std::unique_ptr<struct trace_buffer>> buffers;
+	std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+};
+
+inline struct trace_registry& trace_registry_get()
+{
+	static struct trace_registry registry;
+	return registry;
+}
+
+/// <summary>
+/// Nanoseconds since the first trace event of the process.
+/// </summary>
+inline long long trace_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_registry_get().origin).count();
+}
+
+inline struct trace_buffer& trace_thread_buffer()
+{
+	thread_local struct trace_buffer* buffer = NULL;
+	if (buffer == NULL)
+	{
+		struct trace_registry& registry = trace_registry_get();
+		std::lock_guard<std::mutex> guard(registry.lock);
+		registry.buffers.emplace_back(new struct trace_buffer);
+		buffer = registry.buffers.back().get();
+		buffer->thread = registry.buffers.size();
+		buffer->events.reserve(TRACE_BUFFER_RESERVE);
+	}
+	return *buffer;
+}
+
+/// <summary>
+/// Records the time from its construction to its destruction as a zone.
+/// </summary>
+struct trace_zone
+{
+	const char* name;
+	long long start;
+
+	explicit trace_zone(const char* name)
+		: name(name), start(trace_now())
+	{
+	}
+
+	~trace_zone()
+	{
+		struct trace_event event = { name, 'X', start, trace_now() - start };
+		trace_thread_buffer().events.push_back(event);
+	}
+};
+
+inline void trace_count(const char* name, long long amount)
+{
+	struct trace_event event = { name, 'C', trace_now(), amount };
+	trace_thread_buffer().events.push_back(event);
+}
+
+/// <summary>
+/// Writes the zones of every thread as complete ("X") events and the counters as counter ("C") events
+/// holding their running total over all threads.
+/// </summary>
+/// @warning Call it once the traced threads are done, e.g. at the end of main().
+inline bool trace_dump(const char* filename)
+{
+	struct trace_registry& registry = trace_registry_get();
+	std::lock_guard<std::mutex> guard(registry.lock);
+	std::ofstream out(filename, std::ios::out | std::ios::trunc);
+	out << std::fixed;
+	out.precision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	std::vector<std::pair<long long, const struct trace_event*>> increments;
+	for (size_t b = 0; b < registry.buffers.size(); b++)
+	{
+		const struct trace_buffer& buffer = *registry.buffers[b];
+		for (size_t e = 0; e < buffer.events.size(); e++)
+		{
+			const struct trace_event& event = buffer.events[e];
+			if (event.phase == 'C')
+			{
+				increments.push_back(std::make_pair(event.start, &event));
+				continue;
+			}
+			out << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.thread <<
+				",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.value / 1000.0 << "}";
+			first = false;
+		}
+	}
+
+	// Counter values are totals over all threads, so the increments are summed up in time order.
+	std::stable_sort(increments.begin(), increments.end(),
+		[](const std::pair<long long, const struct trace_event*>& a, const std::pair<long long, const struct trace_event*>& b)
+	{
+		return a.first < b.first;
+	});
+	std::map<std::string, long long> totals;
+	for (size_t i = 0; i < increments.size(); i++)
+	{
+		const struct trace_event& event = *increments[i].second;
+		long long& total = totals[event.name];
+		total = total + event.value;
+		out << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << event.start / 1000.0 <<
+			",\"args\":{\"value\":" << total << "}}";
+		first = false;
+	}
+	out << "\n]}\n";
+
+	if (!out)
+	{
+		std::cerr << "ERROR: Could not write the trace to " << filename << ".\n";
+		return false;
+	}
+	std::cout << "Trace written to " << filename << ".\n";
+	return true;
+}
+
+#if TRACE_ENABLED
+#define TRACE_CONCATENATE_INNER(a, b) a##b
+#define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_INNER(a, b)
+#define TRACE_ZONE(name) struct trace_zone TRACE_CONCATENATE(trace_zone_, __LINE__)(name)
+#define TRACE_COUNTER(name, amount) trace_count(name, amount)
+#define TRACE_DUMP(filename) trace_dump(filename)
+#else
+#define TRACE_ZONE(name) do {} while (0)
+#define TRACE_COUNTER(name, amount) do {} while (0)
+#define TRACE_DUMP(filename) do {} while (0)
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "MemoryStats.h"
+
+/// \file
+
+/// <summary>
+/// Vertices kept as two separate streams instead of interleaved (x, y, r, g, b) records: positions holds
+/// (x, y) and colors holds (r, g, b) for every vertex. Passes that only touch one attribute run over a
+/// contiguous array, and each stream is uploaded into a GL buffer of its own.
+/// </summary>
+struct vertex_store
+{
+	counted_vector<float, vertex_store_memory> positions;
+	counted_vector<float, vertex_store_memory> colors;
+};
+
+inline size_t vertex_store_count(const struct vertex_store& store)
+{
+	return store.positions.size() / 2;
+}
+
+/// <summary>
+/// Resizes both streams to count vertices. New colors are black.
+/// </summary>
+inline void vertex_store_resize(struct vertex_store& store, size_t count)
+{
+	store.positions.resize(2 * count);
+	store.colors.resize(3 * count);
+}
+
+/// <summary>
+/// Maps pixel positions to normalized device coordinates by dividing x by x_extent and y by y_extent.
+/// </summary>
+inline void vertex_store_scale(struct vertex_store& store, double x_extent, double y_extent)
+{
+	float* positions = store.positions.data();
+	size_t count = vertex_store_count(store);
+	for (size_t i = 0; i < count; i++)
+	{
+		positions[2 * i] = positions[2 * i] / x_extent;
+		positions[(2 * i) + 1] = positions[(2 * i) + 1] / y_extent;
+	}
+}
+
+/// <summary>
+/// Uploads the positions into buffers[0] as attribute 0 and the colors into buffers[1] as attribute 1.
+/// </summary>
+/// <param name="buffers"> Two buffer names, generated here</param>
+inline void vertex_store_upload(const struct vertex_store& store, unsigned int buffers[2])
+{
+	glGenBuffers(2, buffers);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+	glBufferData(GL_ARRAY_BUFFER, store.positions.size() * sizeof(float), store.positions.data(), GL_STATIC_DRAW);
+	memory_gl_allocated(MEMORY_STAGE_GL_BUFFERS, store.positions.size() * sizeof(float));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, 0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+	glBufferData(GL_ARRAY_BUFFER, store.colors.size() * sizeof(float), store.colors.data(), GL_STATIC_DRAW);
+	memory_gl_allocated(MEMORY_STAGE_GL_BUFFERS, store.colors.size() * sizeof(float));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, 0);
+}
@@ -1,377 +1,429 @@
-#include "Circle.h"
-
-/// \file
-
-
-
-struct point
-{
-    int16_t red;
-    int16_t green;
-    int16_t blue;
-};
-
-struct basepoint
-{
-    int64_t length;
-    int64_t width;
-    int16_t red;
-    int16_t green;
-    int16_t blue;
-    double dropoff;
-};
-
-
-
-    /// <summary>
-    /// Default constructor
-    /// </summary>
-    /// @warning This initializes x_center, y_center and radius to -1.
-    Circle::Circle(){
-
-    }
-
-    /// <summary>
-    /// Parameterised constructor
-    /// </summary>
-    /// <param name="x"> x coordinate of the center</param>
-    /// <param name="y"> y cooridnate of the center</param>
-    /// <param name="radius"> radius of the circle</param>
-    /// @warning If parameter radius < 0, it will be set to -1.
-    Circle::Circle(int x, int y, int radius) {
-        this->x_center = x;
-        this->y_center = y;
-        this->radius = radius;
-    }
-
-
-    std::string Circle::file_string_transfer(std::ifstream& in)
-    {
-        std::ostringstream sstr;
-        sstr << in.rdbuf();
-        return sstr.str();
-    }
-
-    double Circle::compute_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2)
-    {
-        double temp;
-        uint64_t dlength = std::max(length1, length2) - std::min(length1, length2);
-        uint64_t dwidth = std::max(width1, width2) - std::min(width1, width2);
-        temp = pow(dlength, 2) + pow(dwidth, 2);
-        temp = pow(temp, 0.5);
-        return temp;
-    }
-
-
-    int16_t Circle::main_helper_verifybounds_int16_t(int16_t check)
-    {
-        if (check > 0)
-        {
-            return check;
-        }
-        return 0;
-    }
-
-    void Circle::compute_color(std::vector<float>& point_data, std::vector<struct basepoint> basepoints)
-    {
-        struct point temp;
-        temp.red = 0;
-        temp.green = 0;
-        temp.blue = 0;
-
-        uint64_t x_coordinate = point_data.at(point_data.size() - 2);
-        uint64_t y_coordinate = point_data.at(point_data.size() - 1);
-        for (uint64_t i = 0; i < basepoints.size(); i++)
-        {
-            if ((basepoints.at(i).length == x_coordinate) && (basepoints.at(i).width == y_coordinate))
-            {
-                temp.red = basepoints.at(i).red;
-                temp.green = basepoints.at(i).green;
-                temp.blue = basepoints.at(i).blue;
-                break;
-            }
-            temp.red = temp.red +
-                main_helper_verifybounds_int16_t((double)basepoints.at(i).red * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-            temp.green = temp.green +
-                main_helper_verifybounds_int16_t((double)basepoints.at(i).green * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-            temp.blue = temp.blue +
-                main_helper_verifybounds_int16_t((double)basepoints.at(i).blue * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-        }
-        if (temp.red > 255)
-        {
-            temp.red = 255;
-        }
-        if (temp.green > 255)
-        {
-            temp.green = 255;
-        }
-        if (temp.blue > 255)
-        {
-            temp.blue = 255;
-        }
-
-        point_data.push_back(temp.red / 255.0f);
-        point_data.push_back(temp.green / 255.0f);
-        point_data.push_back(temp.blue / 255.0f);
-    }
-
-    unsigned int Circle::shader_compile(unsigned int shader_type, const std::string& source_code)
-    {
-        unsigned int shader_id = glCreateShader(shader_type);
-        const char* source_code_ptr = source_code.c_str();    // Pointer to given string
-        glShaderSource(shader_id, 1, &source_code_ptr, NULL);
-        glCompileShader(shader_id);
-
-        int compilation_result;
-        glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compilation_result);
-
-        // Check for errors generated.
-        if (compilation_result == GL_FALSE)
-        {
-            int log_length;
-            glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
-            char* log_message = (char*)alloca(log_length * sizeof(char));
-            glGetShaderInfoLog(shader_id, log_length, &log_length, log_message);
-
-            std::cerr << "ERROR: Shader compilation failed." << "\n";
-            std::cerr << "The shader was of type " << shader_type << ".\n";
-            std::cerr << "The program might not operate correctly.\n";
-            std::cerr << "The error encountered was:\n\n";
-
-            std::cerr << log_message << "\n";
-
-            glDeleteShader(shader_id);
-            return 0;
-        }
-
-        return shader_id;
-    }
-
-    unsigned int Circle::shaders_link_and_generate_program(const std::string& vertex_shader, const std::string& fragment_shader)
-    {
-        // Linking vertex and fragment shader and generating resulting program.
-        unsigned int program_id = glCreateProgram();
-        unsigned int vertex_shader_id = shader_compile(GL_VERTEX_SHADER, vertex_shader);
-        unsigned int fragment_shader_id = shader_compile(GL_FRAGMENT_SHADER, fragment_shader);
-
-        glAttachShader(program_id, vertex_shader_id);
-        glAttachShader(program_id, fragment_shader_id);
-        glLinkProgram(program_id);
-        glValidateProgram(program_id);
-
-        // Check for errors generated.
-        int validation_result;
-        glGetProgramiv(program_id, GL_VALIDATE_STATUS, &validation_result);
-        if (validation_result == GL_FALSE)
-        {
-            int log_length;
-            glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
-            char* log_message = (char*)alloca(log_length * sizeof(char));
-            glGetProgramInfoLog(program_id, log_length, &log_length, log_message);
-
-            std::cerr << "ERROR: Shader validation failed." << "\n";
-            std::cerr << "The program might not operate correctly.\n";
-            std::cerr << "The error encountered was:\n\n";
-
-            std::cerr << log_message << "\n";
-
-            glDeleteProgram(program_id);
-            return 0;
-        }
-
-        glDeleteShader(vertex_shader_id);
-        glDeleteShader(fragment_shader_id);
-        return program_id;
-    }
-   
-
-    // this function generates the basepoints. A basepoint is a point whose color values are given by the 
-// random number generator. Only 4 of these are actually generated, the color values of the rest are 
-// determined from these points.
-
-// further discussion is in the algorithm analysis, the basepoints are stored in a vector
-    struct basepoint Circle::basepoint_layout_helper(uint64_t length_l, uint64_t length_r, uint64_t width_u, uint64_t width_d, std::vector<struct basepoint> basepoints, int window_width, int window_height)
-    {
-        struct basepoint temp;
-        
-
-        std::uniform_int_distribution<unsigned long long> rand_length(length_l, length_r);
-        std::uniform_int_distribution<unsigned long long> rand_width(width_u, width_d);
-        std::uniform_int_distribution<short> rand_red(127, 255);
-        std::uniform_int_distribution<short> rand_green(127, 255);
-        std::uniform_int_distribution<short> rand_blue(127, 255);
-        std::uniform_real_distribution<double> rand_dropoff(MIN_DROPOFF_RADIUS, MAX_DROPOFF_RADIUS);
-
-        std::random_device hrng;
-        std::mt19937 engine(hrng());
-
-        temp.length = rand_length(engine);
-        engine.discard(temp.length);
-        temp.width = rand_width(engine);
-        engine.discard(temp.width);
-        temp.red = rand_red(engine);
-        engine.discard(temp.red);
-        temp.green = rand_green(engine);
-        engine.discard(temp.green);
-        temp.blue = rand_blue(engine);
-        engine.discard(temp.blue);
-        temp.dropoff = rand_dropoff(engine);
-        engine.discard(MAX_DROPOFF_RADIUS);
-
-        if (SIMILARITY_THRESHOLD)
-        {
-            for (uint64_t i = 0; i < basepoints.size(); i++)
-            {
-                if ((abs(temp.red - basepoints.at(i).red) < SIMILARITY_THRESHOLD) && (abs(temp.green - basepoints.at(i).green) < SIMILARITY_THRESHOLD) && (abs(temp.blue - basepoints.at(i).blue) < SIMILARITY_THRESHOLD))
-                {
-                    temp = basepoint_layout_helper(length_l, length_r, width_u, width_d, basepoints, window_width, window_height);
-                }
-            }
-        }
-
-
-        return temp;
-    }
-
-
-
-    /// <summary>
-    /// Calculates the position of points on the circle corresponding to the center and radius.
-    /// Pushes the points on the circle onto the active buffer.
-    /// </summary>
-    /// <param name="window_width"> Width of window</param>
-    /// <param name="window_height"> Height of window</param>
-    /// <returns> 0 on successful processing\n -1 on error</returns>
-    /// @warning This function needs to be called before plot() to calculate the position of points.
-    int Circle::process(int window_width, int window_height) {
-
-        std::vector<struct basepoint> basepoints;
-        struct basepoint temp;
-        temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, 0, window_height / WIDTH_SPLIT, basepoints, window_width, window_height);
-        basepoints.push_back(temp);
-        temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width, 0,
-            window_height / WIDTH_SPLIT, basepoints, window_width, window_height);
-        basepoints.push_back(temp);
-        temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, window_height - window_height / WIDTH_SPLIT,
-            window_height, basepoints, window_width, window_height);
-        basepoints.push_back(temp);
-        temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width,
-            window_height - window_height / WIDTH_SPLIT, window_height, basepoints, window_width, window_height);
-        basepoints.push_back(temp);
-
-        auto start_time = std::chrono::system_clock::now();
-        int decision = 1 - radius;
-        int increment_east = 3;
-        int increment_southeast = (-2 * radius) + 5;
-        int x = 0;
-        int y = radius;
-        bool oob_warn = false;  // Boolean flag to check if points go out of bounds of the window.
-
-        while (y >= x)
-        {
-            // Generating coordinates for all points in the circle from the 1/8th part we run our code on.    
-            point_data.push_back(x + x_center);
-            point_data.push_back(y + y_center);
-            compute_color(point_data, basepoints);
-            point_data.push_back(-x + x_center);
-            point_data.push_back(y + y_center);
-            compute_color(point_data, basepoints);
-            point_data.push_back(x + x_center);
-            point_data.push_back(-y + y_center);
-            compute_color(point_data, basepoints);
-            point_data.push_back(-x + x_center);
-            point_data.push_back(-y + y_center);
-            compute_color(point_data, basepoints);
-            point_data.push_back(y + x_center);
-            point_data.push_back(x + y_center);
-            compute_color(point_data, basepoints);
-            point_data.push_back(-y + x_center);
-            point_data.push_back(x + y_center);
-            compute_color(point_data, basepoints);
-            point_data.push_back(y + x_center);
-            point_data.push_back(-x + y_center);
-            compute_color(point_data, basepoints);
-            point_data.push_back(-y + x_center);
-            point_data.push_back(-x + y_center);
-            compute_color(point_data, basepoints);
-
-            if (decision < 0)
-            {
-                decision = decision + increment_east;
-                increment_east = increment_east + 2;
-                increment_southeast = increment_southeast + 2;
-            }
-            else
-            {
-                decision = decision + increment_southeast;
-                increment_east = increment_east + 2;
-                increment_southeast = increment_southeast + 4;
-                y = y - 1;
-            }
-            x = x + 1;
-        }
-
-        for (int i = 0; i < point_data.size(); i = i + 5)
-        {
-            // Converting the values stored to values between -1.0f and 1.0f.
-            point_data.at(i) = (2 * (point_data.at(i) / (double)(window_width))) - 1.0f;
-            point_data.at(i + 1) = (2 * (point_data.at(i + 1) / (double)(window_height))) - 1.0f;
-
-            // If the values surpass the limits set by the boundaries set them to 0 by default and raise bool flag.
-            if ((point_data.at(i) > 1.0f) || (point_data.at(i + 1) > 1.0f) || (point_data.at(i) < (-1.0f)) || (point_data.at(i + 1) < (-1.0f)))
-            {
-                point_data.at(i) = -1.0f;
-                point_data.at(i + 1) = -1.0f;
-                oob_warn = true;
-            }
-        }
-
-        auto end_time = std::chrono::system_clock::now();
-        std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-        std::cout << "Render Compute finished in " << duration.count() << " milliseconds.\n";
-        std::cout << "Points computed: " << point_data.size() / 5 << " . Time per point: " <<
-            duration.count() / (float)(point_data.size() / 5) << " milliseconds.\n";
-
-
-        // Give a warning along with the output if the bool flag defined above is raised.
-        if (oob_warn == true)
-        {
-            std::cerr << "WARNING: Some points are out of bounds of the current window.\n";
-            std::cerr << "They have been moved to (0, 0). Please verify settings.\n";
-
-        }
-
-        unsigned int buffer;
-        glGenBuffers(1, &buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
-        glBufferData(GL_ARRAY_BUFFER, point_data.size() * sizeof(float), &point_data.at(0), GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(sizeof(float) * 2));
-
-        //std::ifstream vertex_shader_source_file;
-        //std::ifstream fragment_shader_source_file;
-
-        //vertex_shader_source_file.open(VERTEX_SHADER_FILENAME, std::ios::in);
-        //fragment_shader_source_file.open(FRAGMENT_SHADER_FILENAME, std::ios::in);
-        //std::string vertex_shader_source = file_string_transfer(vertex_shader_source_file);       // Store the data from the vertex_shader.glsl file as string.
-        //std::string fragment_shader_source = file_string_transfer(fragment_shader_source_file);   // Store the data from the fragment_shader.glsl file as string.
-
-        std::string vertex_shader_source = "#version 330 core\n\nlayout(location = 0) in vec4 position;\nlayout(location = 1) in vec4 color;\nout vec4 color_data;\nvoid main()\n{\n\tgl_Position = position;\n\tcolor_data = color;\n}";
-        std::string fragment_shader_source = "#version 330 core\n\nin vec4 color_data;\nout vec4 color;\nvoid main()\n{\n\tcolor = color_data;\n}";
-
-        unsigned int program_id = shaders_link_and_generate_program(vertex_shader_source, fragment_shader_source);
-        glUseProgram(program_id);
-
-        return 0;
-    }
-
-    /// <summary>
-    /// Plots the circle on the window
-    /// </summary>
-    /// @warning This function needs to be called after the call to process(int window_width, int window_height) 
-    void Circle::plot() {
-        glDrawArrays(GL_POINTS, 0, point_data.size() / 5);    // Draw at the points stored in the vector.
-    }
+#include "Circle.h"
+
+/// \file
+
+
+
+struct point
+{
+    int16_t red;
+    int16_t green;
+    int16_t blue;
+};
+
+struct basepoint
+{
+    int64_t length;
+    int64_t width;
+    int16_t red;
+    int16_t green;
+    int16_t blue;
+    double dropoff;
+};
+
+
+
+    /// <summary>
+    /// Default constructor
+    /// </summary>
+    /// @warning This initializes x_center, y_center and radius to -1.
+    Circle::Circle(){
+        this->point_data = { NULL, 0 };
+        this->arena = &scene_arena();
+    }
+
+    /// <summary>
+    /// Parameterised constructor
+    /// </summary>
+    /// <param name="x"> x coordinate of the center</param>
+    /// <param name="y"> y cooridnate of the center</param>
+    /// <param name="radius"> radius of the circle</param>
+    /// <param name="arena"> Arena the points of the circle are allocated from</param>
+    /// @warning If parameter radius < 0, it will be set to -1.
+    Circle::Circle(int x, int y, int radius, Arena& arena) {
+        this->point_data = { NULL, 0 };
+        this->arena = &arena;
+        this->x_center = x;
+        this->y_center = y;
+        this->radius = radius;
+    }
+
+
+    std::string Circle::file_string_transfer(std::ifstream& in)
+    {
+        std::ostringstream sstr;
+        sstr << in.rdbuf();
+        return sstr.str();
+    }
+
+    double Circle::compute_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2)
+    {
+        double temp;
+        uint64_t dlength = std::max(length1, length2) - std::min(length1, length2);
+        uint64_t dwidth = std::max(width1, width2) - std::min(width1, width2);
+        temp = pow(dlength, 2) + pow(dwidth, 2);
+        temp = pow(temp, 0.5);
+        return temp;
+    }
+
+
+    int16_t Circle::main_helper_verifybounds_int16_t(int16_t check)
+    {
+        if (check > 0)
+        {
+            return check;
+        }
+        return 0;
+    }
+
+    // Computes the color (r, g, b) of a single vertex from its position (x, y).
+    // It only reads the basepoints, so different vertices can be shaded from different threads.
+    void Circle::shade_vertex(const float* position, float* color, const counted_vector<struct basepoint, basepoint_memory>& basepoints)
+    {
+        struct point temp;
+        temp.red = 0;
+        temp.green = 0;
+        temp.blue = 0;
+
+        uint64_t x_coordinate = position[0];
+        uint64_t y_coordinate = position[1];
+        for (uint64_t i = 0; i < basepoints.size(); i++)
+        {
+            if ((basepoints.at(i).length == x_coordinate) && (basepoints.at(i).width == y_coordinate))
+            {
+                temp.red = basepoints.at(i).red;
+                temp.green = basepoints.at(i).green;
+                temp.blue = basepoints.at(i).blue;
+                break;
+            }
+            temp.red = temp.red +
+                main_helper_verifybounds_int16_t((double)basepoints.at(i).red * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
+            temp.green = temp.green +
+                main_helper_verifybounds_int16_t((double)basepoints.at(i).green * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
+            temp.blue = temp.blue +
+                main_helper_verifybounds_int16_t((double)basepoints.at(i).blue * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
+        }
+        if (temp.red > 255)
+        {
+            temp.red = 255;
+        }
+        if (temp.green > 255)
+        {
+            temp.green = 255;
+        }
+        if (temp.blue > 255)
+        {
+            temp.blue = 255;
+        }
+
+        color[0] = temp.red / 255.0f;
+        color[1] = temp.green / 255.0f;
+        color[2] = temp.blue / 255.0f;
+    }
+
+    unsigned int Circle::shader_compile(unsigned int shader_type, const std::string& source_code)
+    {
+        unsigned int shader_id = glCreateShader(shader_type);
+        const char* source_code_ptr = source_code.c_str();    // Pointer to given string
+        glShaderSource(shader_id, 1, &source_code_ptr, NULL);
+        glCompileShader(shader_id);
+
+        int compilation_result;
+        glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compilation_result);
+
+        // Check for errors generated.
+        if (compilation_result == GL_FALSE)
+        {
+            int log_length;
+            glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
+            char* log_message = (char*)alloca(log_length * sizeof(char));
+            glGetShaderInfoLog(shader_id, log_length, &log_length, log_message);
+
+            std::cerr << "ERROR: Shader compilation failed." << "\n";
+            std::cerr << "The shader was of type " << shader_type << ".\n";
+            std::cerr << "The program might not operate correctly.\n";
+            std::cerr << "The error encountered was:\n\n";
+
+            std::cerr << log_message << "\n";
+
+            glDeleteShader(shader_id);
+            return 0;
+        }
+
+        return shader_id;
+    }
+
+    unsigned int Circle::shaders_link_and_generate_program(const std::string& vertex_shader, const std::string& fragment_shader)
+    {
+        // Linking vertex and fragment shader and generating resulting program.
+        unsigned int program_id = glCreateProgram();
+        unsigned int vertex_shader_id = shader_compile(GL_VERTEX_SHADER, vertex_shader);
+        unsigned int fragment_shader_id = shader_compile(GL_FRAGMENT_SHADER, fragment_shader);
+
+        glAttachShader(program_id, vertex_shader_id);
+        glAttachShader(program_id, fragment_shader_id);
+        glLinkProgram(program_id);
+        glValidateProgram(program_id);
+
+        // Check for errors generated.
+        int validation_result;
+        glGetProgramiv(program_id, GL_VALIDATE_STATUS, &validation_result);
+        if (validation_result == GL_FALSE)
+        {
+            int log_length;
+            glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
+            char* log_message = (char*)alloca(log_length * sizeof(char));
+            glGetProgramInfoLog(program_id, log_length, &log_length, log_message);
+
+            std::cerr << "ERROR: Shader validation failed." << "\n";
+            std::cerr << "The program might not operate correctly.\n";
+            std::cerr << "The error encountered was:\n\n";
+
+            std::cerr << log_message << "\n";
+
+            glDeleteProgram(program_id);
+            return 0;
+        }
+
+        glDeleteShader(vertex_shader_id);
+        glDeleteShader(fragment_shader_id);
+        return program_id;
+    }
+   
+
+    // this function generates the basepoints. A basepoint is a point whose color values are given by the 
+// random number generator. Only 4 of these are actually generated, the color values of the rest are 
+// determined from these points.
+
+// further discussion is in the algorithm analysis, the basepoints are stored in a vector
+    struct basepoint Circle::basepoint_layout_helper(uint64_t length_l, uint64_t length_r, uint64_t width_u, uint64_t width_d, const counted_vector<struct basepoint, basepoint_memory>& basepoints, int window_width, int window_height)
+    {
+        TRACE_ZONE("Circle basepoint");
+        struct basepoint temp;
+        
+
+        std::uniform_int_distribution<unsigned long long> rand_length(length_l, length_r);
+        std::uniform_int_distribution<unsigned long long> rand_width(width_u, width_d);
+        std::uniform_int_distribution<short> rand_red(127, 255);
+        std::uniform_int_distribution<short> rand_green(127, 255);
+        std::uniform_int_distribution<short> rand_blue(127, 255);
+        std::uniform_real_distribution<double> rand_dropoff(MIN_DROPOFF_RADIUS, MAX_DROPOFF_RADIUS);
+
+        std::random_device hrng;
+        std::mt19937 engine(hrng());
+
+        temp.length = rand_length(engine);
+        engine.discard(temp.length);
+        temp.width = rand_width(engine);
+        engine.discard(temp.width);
+        temp.red = rand_red(engine);
+        engine.discard(temp.red);
+        temp.green = rand_green(engine);
+        engine.discard(temp.green);
+        temp.blue = rand_blue(engine);
+        engine.discard(temp.blue);
+        temp.dropoff = rand_dropoff(engine);
+        engine.discard(MAX_DROPOFF_RADIUS);
+
+        if (SIMILARITY_THRESHOLD)
+        {
+            for (uint64_t i = 0; i < basepoints.size(); i++)
+            {
+                if ((abs(temp.red - basepoints.at(i).red) < SIMILARITY_THRESHOLD) && (abs(temp.green - basepoints.at(i).green) < SIMILARITY_THRESHOLD) && (abs(temp.blue - basepoints.at(i).blue) < SIMILARITY_THRESHOLD))
+                {
+                    temp = basepoint_layout_helper(length_l, length_r, width_u, width_d, basepoints, window_width, window_height);
+                }
+            }
+        }
+
+
+        return temp;
+    }
+
+
+
+    // Stencils shared by every Circle. The lock keeps circles computed through process_async() from
+    // evicting a stencil while another one is still reading it.
+    static CircleStencilCache stencil_cache(STENCIL_CACHE_CAPACITY);
+    static std::mutex stencil_lock;
+
+    /// <summary>
+    /// Calculates the position of points on the circle corresponding to the center and radius.
+    /// Only fills point_data and makes no GL calls, so it may run on any thread.
+    /// </summary>
+    /// <param name="window_width"> Width of window</param>
+    /// <param name="window_height"> Height of window</param>
+    /// <param name="lane"> Lane of the arena point_data is allocated from, not used by any other thread meanwhile</param>
+    /// <returns> 0 on successful processing\n -1 on error</returns>
+    /// @warning The points have to be uploaded with upload() before plot() can draw them.
+    int Circle::compute(int window_width, int window_height, long lane) {
+        TRACE_ZONE("Circle compute");
+
+        counted_vector<struct basepoint, basepoint_memory> basepoints;
+        struct basepoint temp;
+        temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, 0, window_height / WIDTH_SPLIT, basepoints, window_width, window_height);
+        basepoints.push_back(temp);
+        temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width, 0,
+            window_height / WIDTH_SPLIT, basepoints, window_width, window_height);
+        basepoints.push_back(temp);
+        temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, window_height - window_height / WIDTH_SPLIT,
+            window_height, basepoints, window_width, window_height);
+        basepoints.push_back(temp);
+        temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width,
+            window_height - window_height / WIDTH_SPLIT, window_height, basepoints, window_width, window_height);
+        basepoints.push_back(temp);
+
+        auto start_time = std::chrono::system_clock::now();
+        // Skip the circle if it lies outside the window, and bounds check each point only if it crosses the border.
+        struct viewport view = { 0, 0, window_width, window_height };
+        int clipping = clip_circle(view, x_center, y_center, radius);
+        point_data = { NULL, 0 };
+
+        // Translate the cached stencil for this radius to the center instead of rerunning the midpoint loop.
+        // All positions are written first and then colored as one batch by the parallel shading pass.
+        // A circle outside the window has no points, so it does not build or touch the stencil.
+        if (clipping != CLIP_OUTSIDE)
+        {
+            std::unique_lock<std::mutex> stencil_guard(stencil_lock);
+            const std::vector<int>& offsets = stencil_cache.lookup(radius);
+            point_data = arena->allocate<float>(5 * (offsets.size() / 2), lane);
+            size_t end = 0;
+            for (size_t i = 0; i < offsets.size(); i = i + 2)
+            {
+                int x = offsets[i] + x_center;
+                int y = offsets[i + 1] + y_center;
+                point_data.data[end] = x;
+                point_data.data[end + 1] = y;
+                // A point outside the window is overwritten by the next one.
+                end = end + (((clipping == CLIP_INSIDE) || inside_viewport(view, x, y)) ? 5 : 0);
+            }
+            // The points clipped away stay unused at the end of the slice.
+            point_data.count = end;
+            TRACE_COUNTER("pixels", end / 5);
+            stencil_guard.unlock();
+            parallel_shade(point_data, [this, &basepoints](const float* position, float* color)
+            {
+                shade_vertex(position, color, basepoints);
+            });
+        }
+
+        {
+            TRACE_ZONE("Circle normalize");
+            for (size_t i = 0; i < point_data.count; i = i + 5)
+            {
+                // Converting the values stored to values between -1.0f and 1.0f.
+                point_data.data[i] = (2 * (point_data.data[i] / (double)(window_width))) - 1.0f;
+                point_data.data[i + 1] = (2 * (point_data.data[i + 1] / (double)(window_height))) - 1.0f;
+            }
+        }
+
+        auto end_time = std::chrono::system_clock::now();
+        std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        std::cout << "Render Compute finished in " << duration.count() << " milliseconds.\n";
+        std::cout << "Points computed: " << point_data.count / 5 << " . Time per point: " <<
+            duration.count() / (float)(point_data.count / 5) << " milliseconds.\n";
+
+
+        // Give a warning along with the output if part of the circle was clipped away.
+        if (clipping != CLIP_INSIDE)
+        {
+            std::cerr << "WARNING: Some points are out of bounds of the current window.\n";
+            std::cerr << "They have been clipped. Please verify settings.\n";
+
+        }
+
+        return 0;
+    }
+
+    /// <summary>
+    /// Uploads the points computed by compute() into a new vertex buffer.
+    /// </summary>
+    /// @warning Needs the GL context of the window to be current.
+    void Circle::upload() {
+        TRACE_ZONE("Circle upload");
+        unsigned int buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, point_data.count * sizeof(float), point_data.data, GL_STATIC_DRAW);
+        memory_gl_allocated(MEMORY_STAGE_GL_BUFFERS, point_data.count * sizeof(float));
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(sizeof(float) * 2));
+    }
+
+    /// <summary>
+    /// Compiles and binds the program that draws the points. Independent of the points, so it can be built
+    /// while compute() is still running.
+    /// </summary>
+    /// @warning Needs the GL context of the window to be current.
+    void Circle::build_program() {
+        TRACE_ZONE("Circle build_program");
+        //std::ifstream vertex_shader_source_file;
+        //std::ifstream fragment_shader_source_file;
+
+        //vertex_shader_source_file.open(VERTEX_SHADER_FILENAME, std::ios::in);
+        //fragment_shader_source_file.open(FRAGMENT_SHADER_FILENAME, std::ios::in);
+        //std::string vertex_shader_source = file_string_transfer(vertex_shader_source_file);       // Store the data from the vertex_shader.glsl file as string.
+        //std::string fragment_shader_source = file_string_transfer(fragment_shader_source_file);   // Store the data from the fragment_shader.glsl file as string.
+
+        std::string vertex_shader_source = "#version 330 core\n\nlayout(location = 0) in vec4 position;\nlayout(location = 1) in vec4 color;\nout vec4 color_data;\nvoid main()\n{\n\tgl_Position = position;\n\tcolor_data = color;\n}";
+        std::string fragment_shader_source = "#version 330 core\n\nin vec4 color_data;\nout vec4 color;\nvoid main()\n{\n\tcolor = color_data;\n}";
+
+        unsigned int program_id = shaders_link_and_generate_program(vertex_shader_source, fragment_shader_source);
+        glUseProgram(program_id);
+    }
+
+    /// <summary>
+    /// Computes the points, uploads them and builds the program.
+    /// </summary>
+    /// <param name="window_width"> Width of window</param>
+    /// <param name="window_height"> Height of window</param>
+    /// <returns> 0 on successful processing\n -1 on error</returns>
+    /// @warning This function needs to be called before plot() to calculate the position of points.
+    int Circle::process(int window_width, int window_height) {
+        int result = compute(window_width, window_height);
+        upload();
+        build_program();
+        if (MEMORY_REPORT)
+        {
+            memory_report(std::cout, "Circle::process");
+        }
+        return result;
+    }
+
+    /// <summary>
+    /// Runs compute() on a separate thread, so that the window, the GL context and the program can be set up
+    /// in the meantime. Once the future is ready, call upload() and build_program() on the GL thread.
+    /// </summary>
+    /// <param name="window_width"> Width of window</param>
+    /// <param name="window_height"> Height of window</param>
+    /// <param name="lane"> Lane of the arena passed on to compute()</param>
+    /// <returns> Future holding the result of compute()</returns>
+    std::future<int> Circle::process_async(int window_width, int window_height, long lane) {
+        return std::async(std::launch::async, [this, window_width, window_height, lane]()
+        {
+            return compute(window_width, window_height, lane);
+        });
+    }
+
+    /// <summary>
+    /// Plots the circle on the window
+    /// </summary>
+    /// @warning This function needs to be called after the call to process(int window_width, int window_height) 
+    void Circle::plot() {
+        TRACE_ZONE("Circle plot");
+        glDrawArrays(GL_POINTS, 0, point_data.count / 5);    // Draw at the points stored in the slice.
+    }
+
+    /// <summary>
+    /// Lazily generates the pixels of the circle that fall inside the window, in the order compute() stores
+    /// them, without filling point_data. Feed it to a sink with drain().
+    /// </summary>
+    /// <param name="window_width"> Width of window</param>
+    /// <param name="window_height"> Height of window</param>
+    class circle_pixels Circle::pixels(int window_width, int window_height) const {
+        struct viewport view = { 0, 0, window_width, window_height };
+        return circle_pixels(x_center, y_center, radius, view);
+    }
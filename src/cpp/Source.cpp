@@ -1,48 +1,68 @@
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
-#include<Circle.h>
-#include<Line.h>
-
-int main(void)
-{
-    if (glfwInit() == GLFW_FALSE)
-    {
-        std::cerr << "ERROR: GLFW initialization failed. Exiting.";
-        return 1;
-    }
-
-    GLFWwindow* window = glfwCreateWindow(700, 700, "Line Drawing", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cerr << "ERROR: GLFW failed to initialize drawing window. Exiting.";
-        glfwTerminate();
-        return 1;
-    }
-
-    glfwMakeContextCurrent(window);
-
-    if (glewInit() != GLEW_OK)
-    {
-        std::cerr << "ERROR: GLEW initialization failed. Exiting.";
-        glfwTerminate();
-        return 1;
-    }
-    std::cout << glGetString(GL_VERSION) << "\n";
-
-    Circle line = Circle(300, 400, 100);
-
-    line.process(700, 700);
-
-    while (!glfwWindowShouldClose(window))
-    {
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        line.plot();
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
-
-    glfwTerminate();
-    return 0;
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include<Circle.h>
+#include<Line.h>
+#include<RenderLoop.h>
+#include<Trace.h>
+#include<MemoryStats.h>
+
+#define STATIC_PLOT 0
+#define EVENT_DRIVEN_REDRAW 0
+#define FRAME_STATS 0
+#define FRAME_STATS_OVERLAY 0
+
+int main(void)
+{
+    // The points are computed on another thread while the window, the context and the program are set up.
+    Circle line = Circle(300, 400, 100);
+    std::future<int> processed = line.process_async(700, 700);
+
+    if (glfwInit() == GLFW_FALSE)
+    {
+        std::cerr << "ERROR: GLFW initialization failed. Exiting.";
+        return 1;
+    }
+
+    GLFWwindow* window = glfwCreateWindow(700, 700, "Line Drawing", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cerr << "ERROR: GLFW failed to initialize drawing window. Exiting.";
+        glfwTerminate();
+        return 1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (glewInit() != GLEW_OK)
+    {
+        std::cerr << "ERROR: GLEW initialization failed. Exiting.";
+        glfwTerminate();
+        return 1;
+    }
+    std::cout << glGetString(GL_VERSION) << "\n";
+
+    line.build_program();
+    processed.get();
+    line.upload();
+    // The points live in the vertex buffer from here on, so the arena chunks are free for the next scene.
+    // plot() only needs the count of the slice.
+    scene_arena().reset();
+
+    // The circle is a single primitive, so any range redraws all of it.
+    auto draw_circle = [&](long /* first */, long /* count */)
+    {
+        line.plot();
+    };
+
+    // The toggles of the window loop are described in RenderLoop.h.
+    struct render_loop_options options = { STATIC_PLOT, EVENT_DRIVEN_REDRAW, FRAME_STATS, FRAME_STATS_OVERLAY, NULL };
+    render_loop(window, line.point_data.count / 5, draw_circle, options);
+
+    if (MEMORY_REPORT)
+    {
+        memory_report(std::cout, "main");
+    }
+    TRACE_DUMP("vector_field.trace.json");
+    glfwTerminate();
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,455 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#ifdef __unix__
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Parallel.h"
+#include "RenderContext.h"
+
+#define RENDER_SOCKET_PATH "/tmp/vector_field_render.sock"
+#define RENDER_SERVICE_WORKERS 0
+#define RENDER_SERVICE_MAX_SIDE RENDER_FIELD_FIXED_MAX_SIDE
+#define RENDER_REQUEST_MAX_BYTES 256
+#define RENDER_REQUEST_TIMEOUT_SECONDS 5
+#define REQUEST_INCOMPLETE 0
+#define REQUEST_COMPLETE 1
+#define REQUEST_FAILED 2
+
+// Long-running render service. Instead of asking for one canvas on standard input and drawing it into a
+// window, it listens on a Unix domain socket and renders any number of jobs side by side, for any number of
+// clients. A client connects, sends one request line and reads back the image as a binary PPM, or a line
+// starting with "ERROR:". The requests are
+//
+//     field WIDTH HEIGHT SEED
+//     polyline WIDTH HEIGHT SEED X_START Y_START TOTAL
+//
+// and render what vector_field_line_color and vector_field_polylines_color draw for that canvas and seed.
+// Requests for the same image that arrive while it is queued or being rendered are attached to that job, so
+// it is rendered once and the image is sent to all of them.
+
+#ifdef __unix__
+volatile sig_atomic_t stop_requested = 0;
+
+void stop_handler(int /* signal_number */)
+{
+    stop_requested = 1;
+}
+
+// A job waiting for or being rendered by a worker, with every client waiting for its image.
+struct pending_render
+{
+    struct render_job job;
+    std::vector<int> clients;
+};
+
+// Jobs in the order they were first requested. jobs holds the queued and the running ones, keyed by
+// render_job_key(), which is what lets duplicates find them.
+struct render_queue
+{
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<std::string> order;
+    std::map<std::string, struct pending_render> jobs;
+    bool stopping = false;
+};
+
+// Writes all of buffer to fd, across partial writes. A client that went away only fails its own reply.
+bool send_all(int fd, const void* buffer, size_t size)
+{
+    const char* data = (const char*)buffer;
+    while (size > 0)
+    {
+        ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+        if ((written < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data = data + written;
+        size = size - written;
+    }
+    return true;
+}
+
+void reply_error(int client, const std::string& message)
+{
+    std::string line = "ERROR: " + message + "\n";
+    send_all(client, line.data(), line.size());
+    close(client);
+}
+
+// Parses one request line into job. Returns an empty string on success, or what is wrong with the request.
+std::string parse_request(const std::string& request, struct render_job& job)
+{
+    std::istringstream fields(request);
+    std::string kind;
+    fields >> kind;
+    job.x_start = 0;
+    job.y_start = 0;
+    job.total = 0;
+    if (kind == "field")
+    {
+        job.kind = RENDER_JOB_FIELD;
+        fields >> job.width >> job.height >> job.seed;
+    }
+    else if (kind == "polyline")
+    {
+        job.kind = RENDER_JOB_POLYLINE;
+        fields >> job.width >> job.height >> job.seed >> job.x_start >> job.y_start >> job.total;
+    }
+    else
+    {
+        return "Unknown request \"" + kind + "\".";
+    }
+
+    std::string rest;
+    if (fields.fail() || (fields >> rest))
+    {
+        return "Malformed request.";
+    }
+    // The field glyphs grow with the fifth power of the coordinates, which overflows past this size.
+    if ((job.width <= 0) || (job.height <= 0) || (job.width > RENDER_SERVICE_MAX_SIDE) || (job.height > RENDER_SERVICE_MAX_SIDE))
+    {
+        return "Canvas sides must be between 1 and " + std::to_string(RENDER_SERVICE_MAX_SIDE) + ".";
+    }
+    // The canvas is centered on the origin, as in the polyline program's prompts.
+    if ((std::abs(job.x_start) > (job.width / 2)) || (std::abs(job.y_start) > (job.height / 2)))
+    {
+        return "Polyline start must lie on the canvas, within [" + std::to_string(-(job.width / 2)) + ", " +
+            std::to_string(job.width / 2) + "] x [" + std::to_string(-(job.height / 2)) + ", " + std::to_string(job.height / 2) + "].";
+    }
+    if (job.total < 0)
+    {
+        return "The number of lines must not be negative.";
+    }
+    return "";
+}
+
+// A connection whose request line is still arriving. The accepting thread polls all of them together with
+// the listening socket, so a slow or idle client only ever holds up itself.
+struct request_reader
+{
+    int client;
+    std::string request;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+// Reads what the client has sent so far without blocking. The request is complete at its newline, or at the
+// end of the stream if the client shut down its side after the line. A connection that closes before
+// sending anything, or whose line outgrows RENDER_REQUEST_MAX_BYTES, has failed.
+int read_request(struct request_reader& reader)
+{
+    char buffer[RENDER_REQUEST_MAX_BYTES];
+    while (true)
+    {
+        ssize_t got = recv(reader.client, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if ((got < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        if ((got < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            return REQUEST_INCOMPLETE;
+        }
+        if (got < 0)
+        {
+            return REQUEST_FAILED;
+        }
+        if (got == 0)
+        {
+            return reader.request.empty() ? REQUEST_FAILED : REQUEST_COMPLETE;
+        }
+        reader.request.append(buffer, got);
+        size_t end = reader.request.find('\n');
+        if (end != std::string::npos)
+        {
+            reader.request.resize(end);
+            return REQUEST_COMPLETE;
+        }
+        if (reader.request.size() >= RENDER_REQUEST_MAX_BYTES)
+        {
+            return REQUEST_FAILED;
+        }
+    }
+}
+
+// Queues the job for the client, or attaches the client to the identical job if one is already pending.
+void submit(struct render_queue& queue, const struct render_job& job, int client)
+{
+    std::string key = render_job_key(job);
+    std::lock_guard<std::mutex> guard(queue.lock);
+    std::map<std::string, struct pending_render>::iterator pending = queue.jobs.find(key);
+    if (pending != queue.jobs.end())
+    {
+        pending->second.clients.push_back(client);
+        return;
+    }
+    struct pending_render render = { job, std::vector<int>(1, client) };
+    queue.jobs.emplace(key, render);
+    queue.order.push_back(key);
+    queue.ready.notify_one();
+}
+
+// Parses the finished request of a reader and queues it, or replies with what is wrong with it.
+void dispatch_request(struct render_queue& queue, const struct request_reader& reader)
+{
+    struct render_job job;
+    std::string problem = parse_request(reader.request, job);
+    if (!problem.empty())
+    {
+        reply_error(reader.client, problem);
+        return;
+    }
+    submit(queue, job, reader.client);
+}
+
+// Worker loop: renders the oldest queued job in a context of its own, then sends the image to every client
+// that asked for it, including those that joined while it was being rendered. The image comes from an arena
+// of the worker, reset after every job, so a worker keeps reusing the same chunks for its images.
+void render_worker(struct render_queue& queue)
+{
+    Arena arena(1);
+    while (true)
+    {
+        std::string key;
+        struct render_job job;
+        {
+            std::unique_lock<std::mutex> guard(queue.lock);
+            queue.ready.wait(guard, [&queue]() { return queue.stopping || !queue.order.empty(); });
+            if (queue.order.empty())
+            {
+                return;
+            }
+            key = queue.order.front();
+            queue.order.pop_front();
+            job = queue.jobs[key].job;
+        }
+
+        std::chrono::time_point<std::chrono::system_clock> start_time = std::chrono::system_clock::now();
+        struct slice<unsigned char> pixels = render_job_run(job, arena);
+        std::ostringstream header;
+        header << "P6\n" << job.width << " " << job.height << "\n255\n";
+
+        std::vector<int> clients;
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            clients.swap(queue.jobs[key].clients);
+            queue.jobs.erase(key);
+        }
+        for (size_t c = 0; c < clients.size(); c++)
+        {
+            if (send_all(clients[c], header.str().data(), header.str().size()))
+            {
+                send_all(clients[c], pixels.data, pixels.count);
+            }
+            close(clients[c]);
+        }
+        arena.reset();
+
+        std::chrono::time_point<std::chrono::system_clock> end_time = std::chrono::system_clock::now();
+        std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        std::cout << "Rendered \"" << key << "\" for " << clients.size() << " client(s) in " << duration.count() << " milliseconds.\n";
+    }
+}
+
+int serve(const char* path)
+{
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    unlink(path);
+    if ((listener < 0) || (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) || (listen(listener, SOMAXCONN) != 0))
+    {
+        std::cerr << "ERROR: Could not listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // No SA_RESTART, so that a signal interrupts poll() and the service shuts down cleanly.
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_handler;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    struct render_queue queue;
+    long worker_count = (RENDER_SERVICE_WORKERS > 0) ? RENDER_SERVICE_WORKERS : parallel_worker_count();
+    std::vector<std::thread> workers;
+    for (long w = 0; w < worker_count; w++)
+    {
+        workers.emplace_back(render_worker, std::ref(queue));
+    }
+    std::cout << "Render service listening on " << path << " with " << worker_count << " workers.\n";
+
+    // The listening socket and every connection still sending its request are polled together. Requests
+    // that do not arrive within RENDER_REQUEST_TIMEOUT_SECONDS are answered with an error.
+    std::vector<struct request_reader> readers;
+    while (!stop_requested)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::vector<struct pollfd> watched(1 + readers.size());
+        watched[0].fd = listener;
+        watched[0].events = POLLIN;
+        long wait = -1;
+        for (size_t r = 0; r < readers.size(); r++)
+        {
+            watched[1 + r].fd = readers[r].client;
+            watched[1 + r].events = POLLIN;
+            long left = std::chrono::duration_cast<std::chrono::milliseconds>(readers[r].deadline - now).count();
+            wait = (wait < 0) ? std::max(0l, left) : std::min(wait, std::max(0l, left));
+        }
+        if (poll(watched.data(), watched.size(), wait) < 0)
+        {
+            if (errno != EINTR)
+            {
+                std::cerr << "ERROR: poll() failed: " << std::strerror(errno) << "\n";
+                break;
+            }
+            continue;
+        }
+
+        // Readers are settled first, since accepting below may append to them.
+        now = std::chrono::steady_clock::now();
+        std::vector<struct request_reader> waiting;
+        for (size_t r = 0; r < readers.size(); r++)
+        {
+            int state = (watched[1 + r].revents != 0) ? read_request(readers[r]) : REQUEST_INCOMPLETE;
+            if (state == REQUEST_COMPLETE)
+            {
+                dispatch_request(queue, readers[r]);
+            }
+            else if (state == REQUEST_FAILED)
+            {
+                reply_error(readers[r].client, "No request line received.");
+            }
+            else if (now >= readers[r].deadline)
+            {
+                reply_error(readers[r].client, "Timed out waiting for the request line.");
+            }
+            else
+            {
+                waiting.push_back(readers[r]);
+            }
+        }
+        readers.swap(waiting);
+
+        if (watched[0].revents != 0)
+        {
+            int client = accept(listener, NULL, NULL);
+            if (client < 0)
+            {
+                if ((errno != EINTR) && (errno != ECONNABORTED) && (errno != EAGAIN))
+                {
+                    std::cerr << "ERROR: accept() failed: " << std::strerror(errno) << "\n";
+                    break;
+                }
+                continue;
+            }
+            struct request_reader reader = { client, std::string(), now + std::chrono::seconds(RENDER_REQUEST_TIMEOUT_SECONDS) };
+            readers.push_back(reader);
+        }
+    }
+    for (size_t r = 0; r < readers.size(); r++)
+    {
+        close(readers[r].client);
+    }
+
+    // Jobs already queued are still rendered and delivered before the workers exit.
+    close(listener);
+    unlink(path);
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.stopping = true;
+    }
+    queue.ready.notify_all();
+    for (size_t w = 0; w < workers.size(); w++)
+    {
+        workers[w].join();
+    }
+    std::cout << "Render service stopped.\n";
+    return 0;
+}
+
+// Client side, e.g. for scripts: sends one request to the service and writes the reply to a file.
+int request_image(const char* path, const std::string& request, const char* filename)
+{
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    if ((server < 0) || (connect(server, (struct sockaddr*)&address, sizeof(address)) != 0))
+    {
+        std::cerr << "ERROR: Could not connect to " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::string line = request + "\n";
+    send_all(server, line.data(), line.size());
+
+    std::string reply;
+    char buffer[1 << 16];
+    ssize_t got;
+    while (((got = recv(server, buffer, sizeof(buffer), 0)) > 0) || ((got < 0) && (errno == EINTR)))
+    {
+        if (got > 0)
+        {
+            reply.append(buffer, got);
+        }
+    }
+    close(server);
+    if (reply.compare(0, 6, "ERROR:") == 0)
+    {
+        std::cerr << reply;
+        return 1;
+    }
+    std::ofstream image(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    image.write(reply.data(), reply.size());
+    if (!image)
+    {
+        std::cerr << "ERROR: Could not write " << filename << ".\n";
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+
+int main(int argc, char** argv)
+{
+#ifdef __unix__
+    if ((argc == 4) && (std::string(argv[1]) == "--request"))
+    {
+        return request_image(RENDER_SOCKET_PATH, argv[2], argv[3]);
+    }
+    if (argc == 1)
+    {
+        return serve(RENDER_SOCKET_PATH);
+    }
+    std::cerr << "Usage: " << argv[0] << "\n       " << argv[0] << " --request \"field WIDTH HEIGHT SEED\" output.ppm\n";
+    return 1;
+#else
+    std::cerr << "ERROR: The render service needs Unix domain sockets.\n";
+    return 1;
+#endif
+}
@@ -1,407 +1,493 @@
-#include <cassert>
-#include <cmath>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-#include <vector>
-#include <algorithm>
-#include <random>
-#include <chrono>
-
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
-
-#define VERTEX_SHADER_FILENAME "vertex_shader_color.glsl"
-#define FRAGMENT_SHADER_FILENAME "fragment_shader_color.glsl"
-#define REDUCTION_FACTOR 50
-#define SCALING_FACTOR 5
-#define MIN_DROPOFF_RADIUS 3 * std::max(window_width, window_height) / 4
-#define MAX_DROPOFF_RADIUS std::max(window_width, window_height)
-#define SIMILARITY_THRESHOLD 50
-#define LENGTH_SPLIT 4
-#define WIDTH_SPLIT 4
-
-std::random_device hrng;
-std::mt19937 engine(hrng());
-long window_width;
-long window_height;
-
-struct point
-{
-    int16_t red;
-    int16_t green;
-    int16_t blue;
-};
-
-struct basepoint
-{
-    uint64_t length;
-    uint64_t width;
-    int16_t red;
-    int16_t green;
-    int16_t blue;
-    double dropoff;
-};
-
-bool oob_warn;
-
-std::string file_string_transfer(std::ifstream& in)
-{
-    std::ostringstream sstr;
-    sstr << in.rdbuf();
-    return sstr.str();
-}
-
-unsigned int shader_compile(unsigned int shader_type, const std::string& source_code)
-{
-    unsigned int shader_id = glCreateShader(shader_type);
-    const char* source_code_ptr = source_code.c_str();
-    glShaderSource(shader_id, 1, &source_code_ptr, NULL);
-    glCompileShader(shader_id);
-
-    int compilation_result;
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compilation_result);
-    if (compilation_result == GL_FALSE)
-    {
-        int log_length;
-        glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
-        char *log_message = (char*)alloca(log_length * sizeof(char));
-        glGetShaderInfoLog(shader_id, log_length, &log_length, log_message);
-
-        std::cerr << "ERROR: Shader compilation failed." << "\n";
-        std::cerr << "The shader was of type " << shader_type << ".\n";
-        std::cerr << "The program might not operate correctly.\n";
-        std::cerr << "The error encountered was:\n\n";
-
-        std::cerr << log_message << "\n";
-
-        glDeleteShader(shader_id);
-        return 0;
-    }
-
-    return shader_id;
-}
-
-unsigned int shaders_link_and_generate_program(const std::string& vertex_shader,
-    const std::string& fragment_shader)
-{
-    unsigned int program_id = glCreateProgram();
-    unsigned int vertex_shader_id = shader_compile(GL_VERTEX_SHADER, vertex_shader);
-    unsigned int fragment_shader_id = shader_compile(GL_FRAGMENT_SHADER, fragment_shader);
-
-    glAttachShader(program_id, vertex_shader_id);
-    glAttachShader(program_id, fragment_shader_id);
-    glLinkProgram(program_id);
-    glValidateProgram(program_id);
-
-    int validation_result;
-    glGetProgramiv(program_id, GL_VALIDATE_STATUS, &validation_result);
-    if (validation_result == GL_FALSE)
-    {
-        int log_length;
-        glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
-        char *log_message = (char*) alloca(log_length * sizeof(char));
-        glGetProgramInfoLog(program_id, log_length, &log_length, log_message);
-
-        std::cerr << "ERROR: Shader validation failed." << "\n";
-        std::cerr << "The program might not operate correctly.\n";
-        std::cerr << "The error encountered was:\n\n";
-
-        std::cerr << log_message << "\n";
-
-        glDeleteProgram(program_id);
-        return 0;
-    }
-
-    glDeleteShader(vertex_shader_id);
-    glDeleteShader(fragment_shader_id);
-    return program_id;
-}
-
-double compute_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2)
-{
-    double temp;
-    uint64_t dlength = std::max(length1, length2) - std::min(length1, length2);
-    uint64_t dwidth = std::max(width1, width2) - std::min(width1, width2);
-    temp = pow(dlength, 2) + pow(dwidth, 2);
-    temp = pow(temp, 0.5);
-    return temp;
-}
-
-
-int16_t main_helper_verifybounds_int16_t(int16_t check)
-{
-    if (check > 0)
-    {
-        return check;
-    }
-    return 0;
-}
-
-void compute_color(std::vector<float>& point_data, std::vector<struct basepoint> basepoints)
-{
-    struct point temp;
-    temp.red = 0;
-    temp.green = 0;
-    temp.blue = 0;
-
-    uint64_t x_coordinate = point_data.at(point_data.size() - 2) + (window_width / 2);
-    uint64_t y_coordinate = point_data.at(point_data.size() - 1) + (window_height / 2);
-    for (uint64_t i = 0; i < basepoints.size(); i++)
-    {
-        if ((basepoints.at(i).length == x_coordinate) && (basepoints.at(i).width == y_coordinate))
-        {
-            temp.red = basepoints.at(i).red;
-            temp.green = basepoints.at(i).green;
-            temp.blue = basepoints.at(i).blue;
-            break;
-        }
-        temp.red = temp.red +
-            main_helper_verifybounds_int16_t((double)basepoints.at(i).red * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-        temp.green = temp.green +
-            main_helper_verifybounds_int16_t((double)basepoints.at(i).green * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-        temp.blue = temp.blue +
-            main_helper_verifybounds_int16_t((double)basepoints.at(i).blue * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-    }
-    if (temp.red > 255)
-    {
-        temp.red = 255;
-    }
-    if (temp.green > 255)
-    {
-        temp.green = 255;
-    }
-    if (temp.blue > 255)
-    {
-        temp.blue = 255;
-    }
-
-    point_data.push_back(temp.red / 255.0f);
-    point_data.push_back(temp.green / 255.0f);
-    point_data.push_back(temp.blue / 255.0f);
-}
-
-void circle(std::vector<float>& point_data, long x_initial, long y_initial, long radius,
-    std::vector<struct basepoint> basepoints)
-{
-    long x_centre = x_initial + 20;
-    long y_centre = y_initial + 400;
-
-    long decision = 1 - radius;
-    long increment_east = 3;
-    long increment_southeast = (-2 * radius) + 5;
-    long x = 0;
-    long y = radius;
-    while (y >= x)
-    {
-        point_data.push_back(x + x_centre);
-        point_data.push_back(y + y_centre);
-        compute_color(point_data, basepoints);
-        point_data.push_back(-x + x_centre);
-        point_data.push_back(y + y_centre);
-        compute_color(point_data, basepoints);
-        point_data.push_back(x + x_centre);
-        point_data.push_back(-y + y_centre);
-        compute_color(point_data, basepoints);
-        point_data.push_back(-x + x_centre);
-        point_data.push_back(-y + y_centre);
-        compute_color(point_data, basepoints);
-        point_data.push_back(y + x_centre);
-        point_data.push_back(x + y_centre);
-        compute_color(point_data, basepoints);
-        point_data.push_back(-y + x_centre);
-        point_data.push_back(x + y_centre);
-        compute_color(point_data, basepoints);
-        point_data.push_back(y + x_centre);
-        point_data.push_back(-x + y_centre);
-        compute_color(point_data, basepoints);
-        point_data.push_back(-y + x_centre);
-        point_data.push_back(-x + y_centre);
-        compute_color(point_data, basepoints);
-
-        if (decision < 0)
-        {
-            decision = decision + increment_east;
-            increment_east = increment_east + 2;
-            increment_southeast = increment_southeast + 2;
-        }
-        else
-        {
-            decision = decision + increment_southeast;
-            increment_east = increment_east + 2;
-            increment_southeast = increment_southeast + 4;
-            y = y - 1;
-        }
-        x = x + 1;
-    }
-}
-
-struct basepoint basepoint_layout_helper(uint64_t length_l, uint64_t length_r, uint64_t width_u, uint64_t width_d, std::vector<struct basepoint> basepoints)
-{
-    struct basepoint temp;
-
-
-    std::uniform_int_distribution<unsigned long long> rand_length(length_l, length_r);
-    std::uniform_int_distribution<unsigned long long> rand_width(width_u, width_d);
-    std::uniform_int_distribution<short> rand_red(127, 255);
-    std::uniform_int_distribution<short> rand_green(127, 255);
-    std::uniform_int_distribution<short> rand_blue(127, 255);
-    std::uniform_real_distribution<double> rand_dropoff(MIN_DROPOFF_RADIUS, MAX_DROPOFF_RADIUS);
-
-
-    temp.length = rand_length(engine);
-    engine.discard(temp.length);
-    temp.width = rand_width(engine);
-    engine.discard(temp.width);
-    temp.red = rand_red(engine);
-    engine.discard(temp.red);
-    temp.green = rand_green(engine);
-    engine.discard(temp.green);
-    temp.blue = rand_blue(engine);
-    engine.discard(temp.blue);
-    temp.dropoff = rand_dropoff(engine);
-    engine.discard(MAX_DROPOFF_RADIUS);
-
-    if (SIMILARITY_THRESHOLD)
-    {
-        for (uint64_t i = 0; i < basepoints.size(); i++)
-        {
-            if ((abs(temp.red - basepoints.at(i).red) < SIMILARITY_THRESHOLD) && (abs(temp.green - basepoints.at(i).green) < SIMILARITY_THRESHOLD) && (abs(temp.blue - basepoints.at(i).blue) < SIMILARITY_THRESHOLD))
-            {
-                temp = basepoint_layout_helper(length_l, length_r, width_u, width_d, basepoints);
-            }
-        }
-    }
-
-
-    return temp;
-}
-
-void point_plotter_function(std::vector<float>& point_data, int x_coordinate, int y_coordinate,
-    std::vector<struct basepoint> basepoints)
-{
-    long x_initial = x_coordinate;
-    long y_initial = y_coordinate;
-    long x_vector = x_initial;
-    long y_vector = y_initial;
-    long radius = sqrt((x_vector * x_vector) + (y_vector * y_vector)) / SCALING_FACTOR;
-    circle(point_data, x_initial, y_initial, radius, basepoints);
-}
-
-int main(void)
-{
-    if (glfwInit() == GLFW_FALSE)
-    {
-        std::cerr << "ERROR: GLFW initialization failed. Exiting.";
-        return 1;
-    }
-
-    // Get the boundaries of the window.
-    std::cout << "Enter Window Width: ";
-    std::cin >> window_width;
-    std::cout << "Enter Window Height: ";
-    std::cin >> window_height;
-
-    std::vector<float> point_data;
-
-    std::vector<struct basepoint> basepoints;
-    struct basepoint temp;
-    temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, 0, window_height / WIDTH_SPLIT, basepoints);
-    basepoints.push_back(temp);
-    temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width, 0,
-        window_height / WIDTH_SPLIT, basepoints);
-    basepoints.push_back(temp);
-    temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, window_height - window_height / WIDTH_SPLIT,
-        window_height, basepoints);
-    basepoints.push_back(temp);
-    temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width,
-        window_height - window_height / WIDTH_SPLIT, window_height, basepoints);
-    basepoints.push_back(temp);
-
-    auto start_time = std::chrono::system_clock::now();
-    for (int i = -(window_width / 2); i < (window_width / 2); i = i + REDUCTION_FACTOR)
-    {
-        for (int j = -(window_height / 2); j < (window_height / 2); j = j + REDUCTION_FACTOR)
-        {
-            point_plotter_function(point_data, i, j, basepoints);
-        }
-    }
-
-    for (int i = 0; i < point_data.size(); i = i + 5)
-    {
-        point_data.at(i) = point_data.at(i) / (double)(window_width / 2);
-        point_data.at(i + 1) = point_data.at(i + 1) / (double)(window_height / 2);
-        if ((point_data.at(i) > 1.0f) || (point_data.at(i + 1) > 1.0f) || (point_data.at(i) < (-1.0f)) || (point_data.at(i + 1) < (-1.0f)))
-        {
-            point_data.at(i) = -1.0f;
-            point_data.at(i + 1) = -1.0f;
-            oob_warn = true;
-        }
-    }
-
-    auto end_time = std::chrono::system_clock::now();
-    std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-    std::cout << "Render Compute finished in " << duration.count() << " milliseconds.\n";
-    std::cout << "Points computed: " << point_data.size() / 5 << ". Time per point: " <<
-        duration.count() / (float)(point_data.size() / 5) << " milliseconds.\n";
-    std::cout << point_data.size() << "\n";
-
-    GLFWwindow* window = glfwCreateWindow(window_width, window_height, "Vector Field - Circle Drawing", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cerr << "ERROR: GLFW failed to initialize drawing window. Exiting.";
-        glfwTerminate();
-        exit(1);
-    }
-
-    glfwMakeContextCurrent(window);
-
-    if (glewInit() != GLEW_OK)
-    {
-        std::cerr << "ERROR: GLEW initialization failed. Exiting.";
-        glfwTerminate();
-        exit(1);
-    }
-    std::cout << glGetString(GL_VERSION) << "\n";
-    if (oob_warn == true)
-    {
-        std::cerr << "WARNING: Some points are out of bounds of the current window.\n";
-        std::cerr << "They have been moved to (0, 0). Please verify settings.\n";
-
-    }
-
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, point_data.size() * sizeof(float), &point_data.at(0), GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(sizeof(float) * 2));
-
-   /* std::ifstream vertex_shader_source_file;
-    std::ifstream fragment_shader_source_file;
-
-    vertex_shader_source_file.open(VERTEX_SHADER_FILENAME, std::ios::in);
-    fragment_shader_source_file.open(FRAGMENT_SHADER_FILENAME, std::ios::in);
-    std::string vertex_shader_source = file_string_transfer(vertex_shader_source_file);
-    std::string fragment_shader_source = file_string_transfer(fragment_shader_source_file);*/
-
-    std::string vertex_shader_source = "#version 330 core\n\nlayout(location = 0) in vec4 position;\nlayout(location = 1) in vec4 color;\nout vec4 color_data;\nvoid main()\n{\n\tgl_Position = position;\n\tcolor_data = color;\n}";
-    std::string fragment_shader_source = "#version 330 core\n\nin vec4 color_data;\nout vec4 color;\nvoid main()\n{\n\tcolor = color_data;\n}";
-
-    unsigned int program_id = shaders_link_and_generate_program(vertex_shader_source, fragment_shader_source);
-    glUseProgram(program_id);
-
-    while (!glfwWindowShouldClose(window))
-    {
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDrawArrays(GL_POINTS, 0, point_data.size() / 5);
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
-
-    glfwTerminate();
-    return 0;
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <future>
+#include <cstring>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "Clipping.h"
+#include "Rasterizer.h"
+#include "Parallel.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "RenderLoop.h"
+#include "MemoryStats.h"
+#include "Arena.h"
+
+#define VERTEX_SHADER_FILENAME "vertex_shader_color.glsl"
+#define FRAGMENT_SHADER_FILENAME "fragment_shader_color.glsl"
+#define REDUCTION_FACTOR 50
+#define SCALING_FACTOR 5
+#define MIN_DROPOFF_RADIUS 3 * std::max(window_width, window_height) / 4
+#define MAX_DROPOFF_RADIUS std::max(window_width, window_height)
+#define SIMILARITY_THRESHOLD 50
+#define LENGTH_SPLIT 4
+#define WIDTH_SPLIT 4
+#define STENCIL_CACHE_CAPACITY 64
+#define STATIC_PLOT 0
+#define EVENT_DRIVEN_REDRAW 0
+#define FRAME_STATS 0
+#define FRAME_STATS_OVERLAY 0
+#define PERF_COUNTERS 0
+
+std::random_device hrng;
+std::mt19937 engine(hrng());
+long window_width;
+long window_height;
+
+struct point
+{
+    int16_t red;
+    int16_t green;
+    int16_t blue;
+};
+
+struct basepoint
+{
+    uint64_t length;
+    uint64_t width;
+    int16_t red;
+    int16_t green;
+    int16_t blue;
+    double dropoff;
+};
+
+std::string file_string_transfer(std::ifstream& in)
+{
+    std::ostringstream sstr;
+    sstr << in.rdbuf();
+    return sstr.str();
+}
+
+unsigned int shader_compile(unsigned int shader_type, const std::string& source_code)
+{
+    unsigned int shader_id = glCreateShader(shader_type);
+    const char* source_code_ptr = source_code.c_str();
+    glShaderSource(shader_id, 1, &source_code_ptr, NULL);
+    glCompileShader(shader_id);
+
+    int compilation_result;
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compilation_result);
+    if (compilation_result == GL_FALSE)
+    {
+        int log_length;
+        glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
+        char *log_message = (char*)alloca(log_length * sizeof(char));
+        glGetShaderInfoLog(shader_id, log_length, &log_length, log_message);
+
+        std::cerr << "ERROR: Shader compilation failed." << "\n";
+        std::cerr << "The shader was of type " << shader_type << ".\n";
+        std::cerr << "The program might not operate correctly.\n";
+        std::cerr << "The error encountered was:\n\n";
+
+        std::cerr << log_message << "\n";
+
+        glDeleteShader(shader_id);
+        return 0;
+    }
+
+    return shader_id;
+}
+
+unsigned int shaders_link_and_generate_program(const std::string& vertex_shader,
+    const std::string& fragment_shader)
+{
+    TRACE_ZONE("shader compile");
+    unsigned int program_id = glCreateProgram();
+    unsigned int vertex_shader_id = shader_compile(GL_VERTEX_SHADER, vertex_shader);
+    unsigned int fragment_shader_id = shader_compile(GL_FRAGMENT_SHADER, fragment_shader);
+
+    glAttachShader(program_id, vertex_shader_id);
+    glAttachShader(program_id, fragment_shader_id);
+    glLinkProgram(program_id);
+    glValidateProgram(program_id);
+
+    int validation_result;
+    glGetProgramiv(program_id, GL_VALIDATE_STATUS, &validation_result);
+    if (validation_result == GL_FALSE)
+    {
+        int log_length;
+        glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
+        char *log_message = (char*) alloca(log_length * sizeof(char));
+        glGetProgramInfoLog(program_id, log_length, &log_length, log_message);
+
+        std::cerr << "ERROR: Shader validation failed." << "\n";
+        std::cerr << "The program might not operate correctly.\n";
+        std::cerr << "The error encountered was:\n\n";
+
+        std::cerr << log_message << "\n";
+
+        glDeleteProgram(program_id);
+        return 0;
+    }
+
+    glDeleteShader(vertex_shader_id);
+    glDeleteShader(fragment_shader_id);
+    return program_id;
+}
+
+double compute_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2)
+{
+    double temp;
+    uint64_t dlength = std::max(length1, length2) - std::min(length1, length2);
+    uint64_t dwidth = std::max(width1, width2) - std::min(width1, width2);
+    temp = pow(dlength, 2) + pow(dwidth, 2);
+    temp = pow(temp, 0.5);
+    return temp;
+}
+
+
+int16_t main_helper_verifybounds_int16_t(int16_t check)
+{
+    if (check > 0)
+    {
+        return check;
+    }
+    return 0;
+}
+
+void shade_vertex(const float* position, float* color, const counted_vector<struct basepoint, basepoint_memory>& basepoints)
+{
+    struct point temp;
+    temp.red = 0;
+    temp.green = 0;
+    temp.blue = 0;
+
+    uint64_t x_coordinate = position[0] + (window_width / 2);
+    uint64_t y_coordinate = position[1] + (window_height / 2);
+    for (uint64_t i = 0; i < basepoints.size(); i++)
+    {
+        if ((basepoints.at(i).length == x_coordinate) && (basepoints.at(i).width == y_coordinate))
+        {
+            temp.red = basepoints.at(i).red;
+            temp.green = basepoints.at(i).green;
+            temp.blue = basepoints.at(i).blue;
+            break;
+        }
+        temp.red = temp.red +
+            main_helper_verifybounds_int16_t((double)basepoints.at(i).red * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
+        temp.green = temp.green +
+            main_helper_verifybounds_int16_t((double)basepoints.at(i).green * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
+        temp.blue = temp.blue +
+            main_helper_verifybounds_int16_t((double)basepoints.at(i).blue * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
+    }
+    if (temp.red > 255)
+    {
+        temp.red = 255;
+    }
+    if (temp.green > 255)
+    {
+        temp.green = 255;
+    }
+    if (temp.blue > 255)
+    {
+        temp.blue = 255;
+    }
+
+    color[0] = temp.red / 255.0f;
+    color[1] = temp.green / 255.0f;
+    color[2] = temp.blue / 255.0f;
+}
+
+// Points of the field: every worker allocates the points of its circles from its own lane, and the shading
+// pass and the upload read them gathered into one slice. Reset once they are uploaded.
+Arena field_arena;
+
+// Points of one circle, allocated from the given lane. stencils holds the recently drawn radii of that lane,
+// translated to each centre instead of rerunning the midpoint loop.
+struct slice<float> circle(long lane, CircleStencilCache& stencils, long x_initial, long y_initial, long radius)
+{
+    long x_centre = x_initial + 20;
+    long y_centre = y_initial + 400;
+
+    // Circles entirely outside the window are skipped, and only circles crossing its border pay for a
+    // per-pixel bounds check.
+    struct viewport view = { -(window_width / 2), -(window_height / 2), window_width / 2, window_height / 2 };
+    int clipping = clip_circle(view, x_centre, y_centre, radius);
+    struct slice<float> points = { NULL, 0 };
+    if (clipping == CLIP_OUTSIDE)
+    {
+        return points;
+    }
+
+    // Only positions are written here; the colors are left to the shading pass.
+    const std::vector<int>& offsets = stencils.lookup(radius);
+    points = field_arena.allocate<float>(5 * (offsets.size() / 2), lane);
+    size_t end = 0;
+    for (size_t i = 0; i < offsets.size(); i = i + 2)
+    {
+        long x = offsets[i] + x_centre;
+        long y = offsets[i + 1] + y_centre;
+        points.data[end] = x;
+        points.data[end + 1] = y;
+        // A point outside the window is overwritten by the next one.
+        end = end + (((clipping == CLIP_INSIDE) || inside_viewport(view, x, y)) ? 5 : 0);
+    }
+    // The points clipped away stay unused at the end of the slice.
+    points.count = end;
+    return points;
+}
+
+struct basepoint basepoint_layout_helper(uint64_t length_l, uint64_t length_r, uint64_t width_u, uint64_t width_d, const counted_vector<struct basepoint, basepoint_memory>& basepoints)
+{
+    TRACE_ZONE("basepoint");
+    struct basepoint temp;
+
+
+    std::uniform_int_distribution<unsigned long long> rand_length(length_l, length_r);
+    std::uniform_int_distribution<unsigned long long> rand_width(width_u, width_d);
+    std::uniform_int_distribution<short> rand_red(127, 255);
+    std::uniform_int_distribution<short> rand_green(127, 255);
+    std::uniform_int_distribution<short> rand_blue(127, 255);
+    std::uniform_real_distribution<double> rand_dropoff(MIN_DROPOFF_RADIUS, MAX_DROPOFF_RADIUS);
+
+
+    temp.length = rand_length(engine);
+    engine.discard(temp.length);
+    temp.width = rand_width(engine);
+    engine.discard(temp.width);
+    temp.red = rand_red(engine);
+    engine.discard(temp.red);
+    temp.green = rand_green(engine);
+    engine.discard(temp.green);
+    temp.blue = rand_blue(engine);
+    engine.discard(temp.blue);
+    temp.dropoff = rand_dropoff(engine);
+    engine.discard(MAX_DROPOFF_RADIUS);
+
+    if (SIMILARITY_THRESHOLD)
+    {
+        for (uint64_t i = 0; i < basepoints.size(); i++)
+        {
+            if ((abs(temp.red - basepoints.at(i).red) < SIMILARITY_THRESHOLD) && (abs(temp.green - basepoints.at(i).green) < SIMILARITY_THRESHOLD) && (abs(temp.blue - basepoints.at(i).blue) < SIMILARITY_THRESHOLD))
+            {
+                temp = basepoint_layout_helper(length_l, length_r, width_u, width_d, basepoints);
+            }
+        }
+    }
+
+
+    return temp;
+}
+
+struct slice<float> point_plotter_function(long lane, CircleStencilCache& stencils, int x_coordinate, int y_coordinate)
+{
+    long x_initial = x_coordinate;
+    long y_initial = y_coordinate;
+    long x_vector = x_initial;
+    long y_vector = y_initial;
+    long radius = sqrt((x_vector * x_vector) + (y_vector * y_vector)) / SCALING_FACTOR;
+    return circle(lane, stencils, x_initial, y_initial, radius);
+}
+
+int main(void)
+{
+    if (glfwInit() == GLFW_FALSE)
+    {
+        std::cerr << "ERROR: GLFW initialization failed. Exiting.";
+        return 1;
+    }
+
+    // Get the boundaries of the window.
+    std::cout << "Enter Window Width: ";
+    std::cin >> window_width;
+    std::cout << "Enter Window Height: ";
+    std::cin >> window_height;
+
+    struct slice<float> point_data = { NULL, 0 };
+
+    // The field is computed on a worker thread while the window, the GL context and the shaders are set up
+    // below; GLFW itself has to stay on the main thread. Nothing in here may call GL.
+    std::future<void> field = std::async(std::launch::async, [&]()
+    {
+        counted_vector<struct basepoint, basepoint_memory> basepoints;
+        struct basepoint temp;
+        temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, 0, window_height / WIDTH_SPLIT, basepoints);
+        basepoints.push_back(temp);
+        temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width, 0,
+            window_height / WIDTH_SPLIT, basepoints);
+        basepoints.push_back(temp);
+        temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, window_height - window_height / WIDTH_SPLIT,
+            window_height, basepoints);
+        basepoints.push_back(temp);
+        temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width,
+            window_height - window_height / WIDTH_SPLIT, window_height, basepoints);
+        basepoints.push_back(temp);
+
+        // With PERF_COUNTERS, the hardware counters of this thread and its workers are read around each kernel.
+        struct perf_counters perf;
+        if (PERF_COUNTERS)
+        {
+            perf_counters_open(perf);
+            perf_counters_start(perf);
+        }
+
+        auto start_time = std::chrono::system_clock::now();
+        {
+            // The columns of circles are split between the workers. Each worker allocates from its own lane
+            // and keeps its own stencils, so nothing is locked, and keeps its circles in column order.
+            long columns = ((2 * (window_width / 2)) + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+            std::vector<std::vector<struct slice<float>>> worker_circles(field_arena.lane_count());
+            std::vector<CircleStencilCache> worker_stencils(field_arena.lane_count(), CircleStencilCache(STENCIL_CACHE_CAPACITY));
+            parallel_for_chunks(0, columns, [&worker_circles, &worker_stencils](long column_begin, long column_end, long worker)
+            {
+                TRACE_ZONE("rasterize");
+                for (long c = column_begin; c < column_end; c++)
+                {
+                    int i = -(window_width / 2) + (c * REDUCTION_FACTOR);
+                    for (int j = -(window_height / 2); j < (window_height / 2); j = j + REDUCTION_FACTOR)
+                    {
+                        struct slice<float> points = point_plotter_function(worker, worker_stencils[worker], i, j);
+                        if (points.count > 0)
+                        {
+                            worker_circles[worker].push_back(points);
+                        }
+                    }
+                }
+            });
+
+            // Gathered in worker order, which is column order, so the points come out as from a serial loop.
+            size_t total = 0;
+            for (size_t w = 0; w < worker_circles.size(); w++)
+            {
+                for (size_t k = 0; k < worker_circles[w].size(); k++)
+                {
+                    total = total + worker_circles[w][k].count;
+                }
+            }
+            TRACE_ZONE("gather");
+            point_data = field_arena.allocate<float>(total);
+            size_t end = 0;
+            for (size_t w = 0; w < worker_circles.size(); w++)
+            {
+                for (size_t k = 0; k < worker_circles[w].size(); k++)
+                {
+                    std::memcpy(point_data.data + end, worker_circles[w][k].data, worker_circles[w][k].count * sizeof(float));
+                    end = end + worker_circles[w][k].count;
+                }
+            }
+        }
+        TRACE_COUNTER("pixels", point_data.count / 5);
+        if (PERF_COUNTERS)
+        {
+            perf_counters_report(perf, "Midpoint loop", point_data.count / 5, std::cout);
+            perf_counters_start(perf);
+        }
+
+        // Shading pass: the circles above only emitted positions, and every vertex is colored here in parallel.
+        parallel_shade(point_data, [&basepoints](const float* position, float* color)
+        {
+            shade_vertex(position, color, basepoints);
+        });
+        if (PERF_COUNTERS)
+        {
+            perf_counters_report(perf, "Color evaluation", point_data.count / 5, std::cout);
+            perf_counters_start(perf);
+        }
+
+        {
+            TRACE_ZONE("normalize");
+            for (size_t i = 0; i < point_data.count; i = i + 5)
+            {
+                point_data.data[i] = point_data.data[i] / (double)(window_width / 2);
+                point_data.data[i + 1] = point_data.data[i + 1] / (double)(window_height / 2);
+            }
+        }
+        if (PERF_COUNTERS)
+        {
+            perf_counters_report(perf, "Normalization pass", point_data.count / 5, std::cout);
+            perf_counters_close(perf);
+        }
+
+        auto end_time = std::chrono::system_clock::now();
+        std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        std::cout << "Render Compute finished in " << duration.count() << " milliseconds.\n";
+        std::cout << "Points computed: " << point_data.count / 5 << ". Time per point: " <<
+            duration.count() / (float)(point_data.count / 5) << " milliseconds.\n";
+    });
+
+    GLFWwindow* window = glfwCreateWindow(window_width, window_height, "Vector Field - Circle Drawing", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cerr << "ERROR: GLFW failed to initialize drawing window. Exiting.";
+        glfwTerminate();
+        return 1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (glewInit() != GLEW_OK)
+    {
+        std::cerr << "ERROR: GLEW initialization failed. Exiting.";
+        glfwTerminate();
+        return 1;
+    }
+    std::cout << glGetString(GL_VERSION) << "\n";
+
+    // The shaders do not depend on the field, so they are compiled before waiting for it.
+   /* std::ifstream vertex_shader_source_file;
+    std::ifstream fragment_shader_source_file;
+
+    vertex_shader_source_file.open(VERTEX_SHADER_FILENAME, std::ios::in);
+    fragment_shader_source_file.open(FRAGMENT_SHADER_FILENAME, std::ios::in);
+    std::string vertex_shader_source = file_string_transfer(vertex_shader_source_file);
+    std::string fragment_shader_source = file_string_transfer(fragment_shader_source_file);*/
+
+    std::string vertex_shader_source = "#version 330 core\n\nlayout(location = 0) in vec4 position;\nlayout(location = 1) in vec4 color;\nout vec4 color_data;\nvoid main()\n{\n\tgl_Position = position;\n\tcolor_data = color;\n}";
+    std::string fragment_shader_source = "#version 330 core\n\nin vec4 color_data;\nout vec4 color;\nvoid main()\n{\n\tcolor = color_data;\n}";
+
+    unsigned int program_id = shaders_link_and_generate_program(vertex_shader_source, fragment_shader_source);
+    glUseProgram(program_id);
+
+    field.get();
+    // With every circle clipped away there is nothing to upload or draw.
+    long field_count = point_data.count / 5;
+    if (field_count > 0)
+    {
+        TRACE_ZONE("upload");
+        unsigned int buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, point_data.count * sizeof(float), point_data.data, GL_STATIC_DRAW);
+        memory_gl_allocated(MEMORY_STAGE_GL_BUFFERS, point_data.count * sizeof(float));
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(sizeof(float) * 2));
+    }
+    // The points live in the vertex buffer from here on.
+    field_arena.reset();
+    point_data = { NULL, 0 };
+
+    // Draws count vertices starting at first.
+    auto draw_field = [&](long first, long count)
+    {
+        TRACE_ZONE("draw");
+        if (count == 0)
+        {
+            return;
+        }
+        glDrawArrays(GL_POINTS, first, count);
+    };
+
+    // The toggles of the window loop are described in RenderLoop.h.
+    struct render_loop_options options = { STATIC_PLOT, EVENT_DRIVEN_REDRAW, FRAME_STATS, FRAME_STATS_OVERLAY, NULL };
+    render_loop(window, field_count, draw_field, options);
+
+    if (MEMORY_REPORT)
+    {
+        memory_report(std::cout, "main");
+    }
+    TRACE_DUMP("vector_field_circle_color.trace.json");
+    glfwTerminate();
+    return 0;
 }
\ No newline at end of file
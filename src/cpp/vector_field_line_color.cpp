@@ -1,398 +1,1060 @@
-#include <cassert>
-#include <cmath>
-#include <sstream>
-#include <iostream>
-#include <vector>
-#include <algorithm>
-#include <random>
-#include <chrono>
-#include <string>
-
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
-
-#define REDUCTION_FACTOR 25
-#define SCALING_FACTOR 100000000
-#define MIN_DROPOFF_RADIUS 3*std::max(window_width, window_height)/4
-#define MAX_DROPOFF_RADIUS std::max(window_width, window_height)
-#define SIMILARITY_THRESHOLD 50
-#define LENGTH_SPLIT 4
-#define WIDTH_SPLIT 4
-
-std::random_device hrng;
-std::mt19937 engine(hrng());
-long window_width;
-long window_height;
-
-struct point
-{
-    int16_t red;
-    int16_t green;
-    int16_t blue;
-};
-
-struct basepoint
-{
-    uint64_t length;
-    uint64_t width;
-    int16_t red;
-    int16_t green;
-    int16_t blue;
-    double dropoff;
-};
-
-unsigned int shader_compile(unsigned int shader_type, const std::string& source_code)
-{
-    unsigned int shader_id = glCreateShader(shader_type);
-    const char* source_code_ptr = source_code.c_str();
-    glShaderSource(shader_id, 1, &source_code_ptr, NULL);
-    glCompileShader(shader_id);
-
-    int compilation_result;
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compilation_result);
-    if (compilation_result == GL_FALSE)
-    {
-        int log_length;
-        glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
-        char* log_message = (char*)malloc(sizeof(char) * (log_length));
-        glGetShaderInfoLog(shader_id, log_length, &log_length, log_message);
-
-        std::cerr << "ERROR: Shader compilation failed." << "\n";
-        std::cerr << "The shader was of type " << shader_type << ".\n";
-        std::cerr << "The program might not operate correctly.\n";
-        std::cerr << "The error encountered was:\n\n";
-
-        std::cerr << log_message << "\n";
-
-        glDeleteShader(shader_id);
-        return 0;
-    }
-
-    return shader_id;
-}
-
-unsigned int shaders_link_and_generate_program(const std::string& vertex_shader,
-    const std::string& fragment_shader)
-{
-    unsigned int program_id = glCreateProgram();
-    unsigned int vertex_shader_id = shader_compile(GL_VERTEX_SHADER, vertex_shader);
-    unsigned int fragment_shader_id = shader_compile(GL_FRAGMENT_SHADER, fragment_shader);
-
-    glAttachShader(program_id, vertex_shader_id);
-    glAttachShader(program_id, fragment_shader_id);
-    glLinkProgram(program_id);
-    glValidateProgram(program_id);
-
-    int validation_result;
-    glGetProgramiv(program_id, GL_VALIDATE_STATUS, &validation_result);
-    if (validation_result == GL_FALSE)
-    {
-        int log_length;
-        glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
-        char* log_message = (char*)malloc(sizeof(char) * (log_length));
-        glGetProgramInfoLog(program_id, log_length, &log_length, log_message);
-
-        std::cerr << "ERROR: Shader validation failed." << "\n";
-        std::cerr << "The program might not operate correctly.\n";
-        std::cerr << "The error encountered was:\n\n";
-
-        std::cerr << log_message << "\n";
-
-        glDeleteProgram(program_id);
-        return 0;
-    }
-
-    glDeleteShader(vertex_shader_id);
-    glDeleteShader(fragment_shader_id);
-    return program_id;
-}
-
-double compute_absdistance(uint64_t length1, uint64_t width1, uint64_t length2, uint64_t width2)
-{
-    double temp;
-    uint64_t dlength = std::max(length1, length2) - std::min(length1, length2);
-    uint64_t dwidth = std::max(width1, width2) - std::min(width1, width2);
-    temp = pow(dlength, 2) + pow(dwidth, 2);
-    temp = pow(temp, 0.5);
-    return temp;
-}
-
-
-int16_t main_helper_verifybounds_int16_t(int16_t check)
-{
-    if (check > 0)
-    {
-        return check;
-    }
-    return 0;
-}
-
-void compute_color(std::vector<float>& point_data, std::vector<struct basepoint> basepoints)
-{
-    struct point temp;
-    temp.red = 0;
-    temp.green = 0;
-    temp.blue = 0;
-
-    uint64_t x_coordinate = point_data.at(point_data.size() - 2) + (window_width / 2);
-    uint64_t y_coordinate = point_data.at(point_data.size() - 1) + (window_height / 2);
-    for (uint64_t i = 0; i < basepoints.size(); i++)
-    {
-        if ((basepoints.at(i).length == x_coordinate) && (basepoints.at(i).width == y_coordinate))
-        {
-            temp.red = basepoints.at(i).red;
-            temp.green = basepoints.at(i).green;
-            temp.blue = basepoints.at(i).blue;
-            break;
-        }
-        temp.red = temp.red +
-            main_helper_verifybounds_int16_t((double)basepoints.at(i).red * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-        temp.green = temp.green +
-            main_helper_verifybounds_int16_t((double)basepoints.at(i).green * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-        temp.blue = temp.blue +
-            main_helper_verifybounds_int16_t((double)basepoints.at(i).blue * (1.0 - ((1.0 / basepoints.at(i).dropoff) * compute_absdistance(x_coordinate, y_coordinate, basepoints.at(i).length, basepoints.at(i).width))));
-    }
-    if (temp.red > 255)
-    {
-        temp.red = 255;
-    }
-    if (temp.green > 255)
-    {
-        temp.green = 255;
-    }
-    if (temp.blue > 255)
-    {
-        temp.blue = 255;
-    }
-
-    point_data.push_back(temp.red / 255.0f);
-    point_data.push_back(temp.green / 255.0f);
-    point_data.push_back(temp.blue / 255.0f);
-}
-
-void line(std::vector<float>& point_data, int x_initial, int y_initial, int x_final, int y_final,
-    std::vector<struct basepoint>& basepoints)
-{
-    int decision;
-    int inc1;
-    int inc2;
-    int delta_x = ((x_final - x_initial) >= 0) ? (x_final - x_initial) : -(x_final - x_initial);
-    int delta_y = ((y_final - y_initial) >= 0) ? (y_final - y_initial) : -(y_final - y_initial);
-    int increment_x = (x_final < x_initial) ? -1 : 1;
-    int increment_y = (y_final < y_initial) ? -1 : 1;
-    int x = x_initial;
-    int y = y_initial;
-    if (delta_x > delta_y)
-    {
-        point_data.push_back(x);
-        point_data.push_back(y);
-        compute_color(point_data, basepoints);
-
-        decision = 2 * delta_y - delta_x;
-        inc1 = 2 * (delta_y - delta_x);
-        inc2 = 2 * delta_y;
-        for (int i = 0; i < delta_x; i++)
-        {
-            if (decision >= 0)
-            {
-                y = y + increment_y;
-                decision = decision + inc1;
-            }
-            else
-            {
-                decision = decision + inc2;
-            }
-            x = x + increment_x;
-            point_data.push_back(x);
-            point_data.push_back(y);
-            compute_color(point_data, basepoints);
-        }
-    }
-    else
-    {
-        point_data.push_back(x);
-        point_data.push_back(y);
-        compute_color(point_data, basepoints);
-
-        decision = 2 * delta_x - delta_y;
-        inc1 = 2 * (delta_x - delta_y);
-        inc2 = 2 * delta_x;
-        for (int i = 0; i < delta_y; i++)
-        {
-            if (decision >= 0)
-            {
-                x = x + increment_x;
-                decision = decision + inc1;
-            }
-            else
-            {
-                decision = decision + inc2;
-            }
-            y = y + increment_y;
-            point_data.push_back(x);
-            point_data.push_back(y);
-            compute_color(point_data, basepoints);
-        }
-    }
-}
-void arrow(std::vector<float>& point_data, long x_final, long y_final, long x_vector, long y_vector,
-    std::vector<struct basepoint>& basepoints)
-{
-    float length = sqrt((x_vector * x_vector) + (y_vector * y_vector));
-    long delta_x = 3 * x_vector / length;
-    long delta_y = 3 * y_vector / length;
-    line(point_data, x_final, y_final, x_final - delta_x - delta_y, y_final + delta_x - delta_y, basepoints);
-    line(point_data, x_final, y_final, x_final - delta_x + delta_y, y_final - delta_x - delta_y, basepoints);
-}
-void point_plotter_function(std::vector<float>& point_data, int x_coordinate, int y_coordinate,
-    std::vector<struct basepoint>& basepoints)
-{
-    long x_initial = x_coordinate;
-    long y_initial = y_coordinate;
-    long x_vector = (x_initial * x_initial * x_initial * x_initial * y_initial);
-    long y_vector = (y_initial * y_initial * y_initial * y_initial * x_initial);
-    long x_final = x_initial + (x_vector / SCALING_FACTOR);
-    long y_final = y_initial + (y_vector / SCALING_FACTOR);
-    line(point_data, x_initial, y_initial, x_final, y_final, basepoints);
-    arrow(point_data, x_final, y_final, x_vector / SCALING_FACTOR, y_vector / SCALING_FACTOR, basepoints);
-}
-
-struct basepoint basepoint_layout_helper(uint64_t length_l, uint64_t length_r, uint64_t width_u, uint64_t width_d, std::vector<struct basepoint> basepoints)
-{
-    struct basepoint temp;
-
-
-    std::uniform_int_distribution<uint64_t> rand_length(length_l, length_r);
-    std::uniform_int_distribution<uint64_t> rand_width(width_u, width_d);
-    std::uniform_int_distribution<uint16_t> rand_red(127, 255);
-    std::uniform_int_distribution<uint16_t> rand_green(127, 255);
-    std::uniform_int_distribution<uint16_t> rand_blue(127, 255);
-    std::uniform_real_distribution<double> rand_dropoff(MIN_DROPOFF_RADIUS, MAX_DROPOFF_RADIUS);
-
-
-    temp.length = rand_length(engine);
-    engine.discard(temp.length);
-    temp.width = rand_width(engine);
-    engine.discard(temp.width);
-    temp.red = rand_red(engine);
-    engine.discard(temp.red);
-    temp.green = rand_green(engine);
-    engine.discard(temp.green);
-    temp.blue = rand_blue(engine);
-    engine.discard(temp.blue);
-    temp.dropoff = rand_dropoff(engine);
-    engine.discard(MAX_DROPOFF_RADIUS);
-
-    if (SIMILARITY_THRESHOLD)
-    {
-        for (uint64_t i = 0; i < basepoints.size(); i++)
-        {
-            if ((abs(temp.red - basepoints.at(i).red) < SIMILARITY_THRESHOLD) && (abs(temp.green - basepoints.at(i).green) < SIMILARITY_THRESHOLD) && (abs(temp.blue - basepoints.at(i).blue) < SIMILARITY_THRESHOLD))
-            {
-                temp = basepoint_layout_helper(length_l, length_r, width_u, width_d, basepoints);
-            }
-        }
-    }
-
-
-    return temp;
-}
-
-
-
-int main(void)
-{
-    if (glfwInit() == GLFW_FALSE)
-    {
-        std::cerr << "ERROR: GLFW initialization failed. Exiting.";
-        return 1;
-    }
-
-    // Get the boundaries of the window.
-    std::cout << "Enter Window Width: ";
-    std::cin >> window_width;
-    std::cout << "Enter Window Height: ";
-    std::cin >> window_height;
-
-    std::vector<struct basepoint> basepoints;
-    struct basepoint temp;
-    temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, 0, window_height / WIDTH_SPLIT, basepoints);
-    basepoints.push_back(temp);
-    temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width, 0,
-        window_height / WIDTH_SPLIT, basepoints);
-    basepoints.push_back(temp);
-    temp = basepoint_layout_helper(0, window_width / LENGTH_SPLIT, window_height - window_height / WIDTH_SPLIT,
-        window_height, basepoints);
-    basepoints.push_back(temp);
-    temp = basepoint_layout_helper(window_width - window_width / LENGTH_SPLIT, window_width,
-        window_height - window_height / WIDTH_SPLIT, window_height, basepoints);
-    basepoints.push_back(temp);
-
-    std::vector<float> point_data;
-    std::chrono::time_point<std::chrono::system_clock> start_time = std::chrono::system_clock::now();
-    for (long i = -(window_width / 2); i < (window_width / 2); i = i + REDUCTION_FACTOR)
-    {
-        for (long j = -(window_height / 2); j < (window_height / 2); j = j + REDUCTION_FACTOR)
-        {
-            point_plotter_function(point_data, i, j, basepoints);
-        }
-    }
-
-    for (int i = 0; i < point_data.size(); i = i + 5)
-    {
-        point_data.at(i) = point_data.at(i) / (double)(window_width / 2);
-        point_data.at(i + 1) = point_data.at(i + 1) / (double)(window_height / 2);
-    }
-
-    std::chrono::time_point<std::chrono::system_clock> end_time = std::chrono::system_clock::now();
-    std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-    std::cout << "Render Compute finished in " << duration.count() << " milliseconds.\n";
-    std::cout << "Points computed: " << point_data.size() / 5 << ". Time per point: " <<
-        duration.count() / (float)(point_data.size() / 5) << " milliseconds.\n";
-
-    GLFWwindow* window = glfwCreateWindow(window_width, window_height, "Vector Field - Line Drawing", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cerr << "ERROR: GLFW failed to initialize drawing window. Exiting.";
-        glfwTerminate();
-        return 1;
-    }
-
-    glfwMakeContextCurrent(window);
-
-    if (glewInit() != GLEW_OK)
-    {
-        std::cerr << "ERROR: GLEW initialization failed. Exiting.";
-        glfwTerminate();
-        return 1;
-    }
-    std::cout << glGetString(GL_VERSION) << "\n";
-
-
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, point_data.size() * sizeof(float), &point_data.at(0), GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(sizeof(float) * 2));
-
-    std::string vertex_shader_source = "#version 330 core\n\nlayout(location = 0) in vec4 position;\nlayout(location = 1) in vec4 color;\nout vec4 color_data;\nvoid main()\n{\n\tgl_Position = position;\n\tcolor_data = color;\n}";
-    std::string fragment_shader_source = "#version 330 core\n\nin vec4 color_data;\nout vec4 color;\nvoid main()\n{\n\tcolor = color_data;\n}";
-
-    unsigned int program_id = shaders_link_and_generate_program(vertex_shader_source, fragment_shader_source);
-    glUseProgram(program_id);
-
-    while (!glfwWindowShouldClose(window))
-    {
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDrawArrays(GL_POINTS, 0, point_data.size() / 5);
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
-
-    glfwTerminate();
-    return 0;
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <string>
+#include <future>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+#ifdef __unix__
+#include <cerrno>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "Clipping.h"
+#include "Rasterizer.h"
+#include "Arrowhead.h"
+#include "InstancedArrows.h"
+#include "Parallel.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "VertexStore.h"
+#include "PixelGenerators.h"
+#include "RenderLoop.h"
+#include "MemoryStats.h"
+#include "RenderContext.h"
+
+#define REDUCTION_FACTOR RENDER_FIELD_REDUCTION_FACTOR
+#define INSTANCED_ARROWS 0
+#define SOA_VERTICES 0
+#define STATIC_PLOT 0
+#define EVENT_DRIVEN_REDRAW 0
+#define FRAME_STATS 0
+#define FRAME_STATS_OVERLAY 0
+#define RECOLOR_SECONDS 0
+#define RECOLOR_BANDS 16
+#define PERF_COUNTERS 0
+#define MAGNITUDE_FIXED 0
+#define MAGNITUDE_LINEAR 1
+#define MAGNITUDE_LOG 2
+#define MAGNITUDE_MODE MAGNITUDE_FIXED
+#define GLYPH_MAX_LENGTH (REDUCTION_FACTOR - 1)
+#define GLYPH_MAX_POINTS (GLYPH_MAX_LENGTH + 1 + 2 * ARROWHEAD_STAMP_POINTS)
+#define TILED_EXPORT 0
+#define TILE_SIZE 2048
+#define TILED_EXPORT_FILENAME "vector_field.ppm"
+#define RENDER_FARM_WORKERS 0
+
+std::random_device hrng;
+long window_width;
+long window_height;
+double magnitude_max;
+
+unsigned int shader_compile(unsigned int shader_type, const std::string& source_code)
+{
+    unsigned int shader_id = glCreateShader(shader_type);
+    const char* source_code_ptr = source_code.c_str();
+    glShaderSource(shader_id, 1, &source_code_ptr, NULL);
+    glCompileShader(shader_id);
+
+    int compilation_result;
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compilation_result);
+    if (compilation_result == GL_FALSE)
+    {
+        int log_length;
+        glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &log_length);
+        char* log_message = (char*)malloc(sizeof(char) * (log_length));
+        glGetShaderInfoLog(shader_id, log_length, &log_length, log_message);
+
+        std::cerr << "ERROR: Shader compilation failed." << "\n";
+        std::cerr << "The shader was of type " << shader_type << ".\n";
+        std::cerr << "The program might not operate correctly.\n";
+        std::cerr << "The error encountered was:\n\n";
+
+        std::cerr << log_message << "\n";
+
+        glDeleteShader(shader_id);
+        return 0;
+    }
+
+    return shader_id;
+}
+
+unsigned int shaders_link_and_generate_program(const std::string& vertex_shader,
+    const std::string& fragment_shader)
+{
+    TRACE_ZONE("shader compile");
+    unsigned int program_id = glCreateProgram();
+    unsigned int vertex_shader_id = shader_compile(GL_VERTEX_SHADER, vertex_shader);
+    unsigned int fragment_shader_id = shader_compile(GL_FRAGMENT_SHADER, fragment_shader);
+
+    glAttachShader(program_id, vertex_shader_id);
+    glAttachShader(program_id, fragment_shader_id);
+    glLinkProgram(program_id);
+    glValidateProgram(program_id);
+
+    int validation_result;
+    glGetProgramiv(program_id, GL_VALIDATE_STATUS, &validation_result);
+    if (validation_result == GL_FALSE)
+    {
+        int log_length;
+        glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &log_length);
+        char* log_message = (char*)malloc(sizeof(char) * (log_length));
+        glGetProgramInfoLog(program_id, log_length, &log_length, log_message);
+
+        std::cerr << "ERROR: Shader validation failed." << "\n";
+        std::cerr << "The program might not operate correctly.\n";
+        std::cerr << "The error encountered was:\n\n";
+
+        std::cerr << log_message << "\n";
+
+        glDeleteProgram(program_id);
+        return 0;
+    }
+
+    glDeleteShader(vertex_shader_id);
+    glDeleteShader(fragment_shader_id);
+    return program_id;
+}
+
+// Writes the arrowhead pixels at (x_final, y_final) that fall inside the window into vertices, Stride floats
+// apart, and returns their number. With vertices NULL the pixels are only counted.
+template <long Stride>
+long arrow(float* vertices, long x_final, long y_final, long x_vector, long y_vector)
+{
+    const struct arrowhead_stamp& stamp = arrowhead_stamp_for(x_vector, y_vector);
+    // Every stamp fits in a square of half-size 2 * ARROWHEAD_REACH around the tip.
+    struct viewport view = { -(window_width / 2), -(window_height / 2), window_width / 2, window_height / 2 };
+    int clipping = clip_circle(view, x_final, y_final, 2 * ARROWHEAD_REACH);
+    if (clipping == CLIP_OUTSIDE)
+    {
+        return 0;
+    }
+    long count = 0;
+    for (int i = 0; i < 2 * stamp.count; i = i + 2)
+    {
+        if ((clipping == CLIP_PARTIAL) && !inside_viewport(view, x_final + stamp.offsets[i], y_final + stamp.offsets[i + 1]))
+        {
+            continue;
+        }
+        if (vertices != NULL)
+        {
+            vertices[Stride * count] = x_final + stamp.offsets[i];
+            vertices[(Stride * count) + 1] = y_final + stamp.offsets[i + 1];
+        }
+        count = count + 1;
+    }
+    return count;
+}
+
+// Pre-pass over the whole grid that finds the largest field magnitude, one chunk of columns per thread.
+double magnitude_prepass()
+{
+    long columns = (window_width + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+    std::vector<double> worker_max(parallel_worker_count(), 0.0);
+    parallel_for_chunks(0, columns, [&worker_max](long column_begin, long column_end, long worker)
+    {
+        for (long column = column_begin; column < column_end; column++)
+        {
+            long i = -(window_width / 2) + column * REDUCTION_FACTOR;
+            if (i >= (window_width / 2))
+            {
+                break;
+            }
+            for (long j = -(window_height / 2); j < (window_height / 2); j = j + REDUCTION_FACTOR)
+            {
+                double x_vector;
+                double y_vector;
+                render_field_value(i, j, x_vector, y_vector);
+                worker_max[worker] = std::max(worker_max[worker], std::hypot(x_vector, y_vector));
+            }
+        }
+    });
+    return *std::max_element(worker_max.begin(), worker_max.end());
+}
+
+// Vector drawn for the grid point, in pixels. MAGNITUDE_FIXED is the fixed scale of render_field_vector and has no
+// length bound. MAGNITUDE_LINEAR and MAGNITUDE_LOG map magnitude_max to GLYPH_MAX_LENGTH, so no glyph leaves
+// its cell and every cell emits at most GLYPH_MAX_POINTS pixels.
+void glyph_vector(long x, long y, long& x_vector, long& y_vector)
+{
+    if ((MAGNITUDE_MODE == MAGNITUDE_FIXED) || (magnitude_max <= 0.0))
+    {
+        render_field_vector(x, y, x_vector, y_vector);
+        return;
+    }
+
+    double field_x;
+    double field_y;
+    render_field_value(x, y, field_x, field_y);
+    double magnitude = std::hypot(field_x, field_y);
+    double length = GLYPH_MAX_LENGTH * (magnitude / magnitude_max);
+    if (MAGNITUDE_MODE == MAGNITUDE_LOG)
+    {
+        length = GLYPH_MAX_LENGTH * (std::log1p(magnitude) / std::log1p(magnitude_max));
+    }
+    x_vector = (magnitude > 0.0) ? (long)(field_x * (length / magnitude)) : 0;
+    y_vector = (magnitude > 0.0) ? (long)(field_y * (length / magnitude)) : 0;
+}
+
+// A grid cell, planned before anything is rasterized: its glyph, the steps of the shaft that are inside the
+// window and the number of pixels it emits in total. Glyph lengths grow steeply towards the edges of the
+// field, so the per-cell cost varies by orders of magnitude and is only known once the glyph is.
+struct cell_plan
+{
+    long x_initial;
+    long y_initial;
+    long x_vector;
+    long y_vector;
+    long first;
+    long last;
+    long points;
+};
+
+struct cell_plan plan_cell(long x, long y)
+{
+    struct cell_plan plan;
+    plan.x_initial = x;
+    plan.y_initial = y;
+    glyph_vector(x, y, plan.x_vector, plan.y_vector);
+    long x_final = x + plan.x_vector;
+    long y_final = y + plan.y_vector;
+
+    // Only the steps whose pixels land inside the window are rasterized.
+    struct viewport view = { -(window_width / 2), -(window_height / 2), window_width / 2, window_height / 2 };
+    if (!clip_line_steps(view, x, y, x_final, y_final, plan.first, plan.last))
+    {
+        plan.first = 0;
+        plan.last = -1;
+    }
+    plan.points = (plan.last - plan.first + 1) + arrow<5>(NULL, x_final, y_final, plan.x_vector, plan.y_vector);
+    return plan;
+}
+
+// Writes the plan.points vertices of a planned cell, shaft first and then arrowhead, Stride floats apart:
+// 5 for interleaved (x, y, r, g, b) vertices and 2 for the position stream of a vertex_store. Only
+// positions are written; their colors are left to the shading pass.
+template <long Stride>
+void render_cell(float* vertices, const struct cell_plan& plan)
+{
+    long x_final = plan.x_initial + plan.x_vector;
+    long y_final = plan.y_initial + plan.y_vector;
+    if (plan.first <= plan.last)
+    {
+        struct strided_sink<Stride, float> sink = { vertices };
+        rasterize_line(sink, plan.x_initial, plan.y_initial, x_final, y_final, plan.first, plan.last);
+    }
+    arrow<Stride>(vertices + (Stride * (plan.last - plan.first + 1)), x_final, y_final, plan.x_vector, plan.y_vector);
+}
+
+// Plans every cell of the grid in parallel, column-major as the cells used to be drawn, and prefix sums the
+// pixel counts into offsets: cell c owns vertices offsets[c] to offsets[c + 1] - 1 of point_data.
+void plan_grid(counted_vector<struct cell_plan, cell_plan_memory>& plan, std::vector<long>& offsets)
+{
+    TRACE_ZONE("plan");
+    long columns = ((2 * (window_width / 2)) + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+    long rows = ((2 * (window_height / 2)) + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+    plan.resize(columns * rows);
+    parallel_for_chunks(0, columns, [&plan, rows](long column_begin, long column_end, long /* worker */)
+    {
+        for (long column = column_begin; column < column_end; column++)
+        {
+            for (long row = 0; row < rows; row++)
+            {
+                plan[(column * rows) + row] = plan_cell(-(window_width / 2) + (column * REDUCTION_FACTOR),
+                    -(window_height / 2) + (row * REDUCTION_FACTOR));
+            }
+        }
+    });
+
+    offsets.assign(plan.size() + 1, 0);
+    for (size_t c = 0; c < plan.size(); c++)
+    {
+        offsets[c + 1] = offsets[c] + plan[c].points;
+    }
+}
+
+// Instanced counterpart of render_cell. Instead of rasterizing the shaft and the arrowhead,
+// a single instance (x, y, r, g, b, x_vector, y_vector) is emitted and the glyph is built in the vertex shader.
+void point_plotter_function_instanced(counted_vector<float, instance_data_memory>& instance_data, int x_coordinate, int y_coordinate)
+{
+    long x_initial = x_coordinate;
+    long y_initial = y_coordinate;
+    long x_vector;
+    long y_vector;
+    glyph_vector(x_initial, y_initial, x_vector, y_vector);
+    instanced_arrow_append(instance_data, x_initial, y_initial, x_vector, y_vector);
+}
+
+// Sink that shades every pixel like the shading pass does and paints it into an RGB tile, stored from its
+// top row down. The generators feeding it are clipped to the tile, so every pixel lands inside.
+struct tile_sink
+{
+    unsigned char* pixels;
+    struct viewport tile;
+    const struct render_context& context;
+
+    void emit(const int* x, const int* y, int count)
+    {
+        long tile_width = tile.x_max - tile.x_min + 1;
+        for (int j = 0; j < count; j++)
+        {
+            render_shade(context, x[j], y[j], pixels + (3 * (((tile.y_max - y[j]) * tile_width) + (x[j] - tile.x_min))));
+        }
+    }
+};
+
+// Rasterizes and colors the glyphs that touch the tile into pixels. In the magnitude modes a glyph stays
+// within GLYPH_MAX_LENGTH of its grid point, so only the cells within that reach of the tile are visited;
+// MAGNITUDE_FIXED glyphs are unbounded and every cell has to be checked. A pixel's color only depends on
+// its position, so overlapping glyphs give the same image whatever order they are drawn in.
+void render_tile(const struct viewport& tile, unsigned char* pixels, const struct render_context& context)
+{
+    long reach = (MAGNITUDE_MODE == MAGNITUDE_FIXED) ? (window_width + window_height) : (GLYPH_MAX_LENGTH + 2 * ARROWHEAD_REACH);
+    long columns = ((2 * (window_width / 2)) + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+    long rows = ((2 * (window_height / 2)) + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+    long column_begin = (std::max(0l, tile.x_min - reach + (window_width / 2)) + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+    long column_end = std::min(columns, ((tile.x_max + reach + (window_width / 2)) / REDUCTION_FACTOR) + 1);
+    long row_begin = (std::max(0l, tile.y_min - reach + (window_height / 2)) + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR;
+    long row_end = std::min(rows, ((tile.y_max + reach + (window_height / 2)) / REDUCTION_FACTOR) + 1);
+
+    struct tile_sink sink = { pixels, tile, context };
+    long emitted = 0;
+    for (long column = column_begin; column < column_end; column++)
+    {
+        for (long row = row_begin; row < row_end; row++)
+        {
+            long x = -(window_width / 2) + (column * REDUCTION_FACTOR);
+            long y = -(window_height / 2) + (row * REDUCTION_FACTOR);
+            long x_vector;
+            long y_vector;
+            glyph_vector(x, y, x_vector, y_vector);
+            const struct arrowhead_stamp& stamp = arrowhead_stamp_for(x_vector, y_vector);
+            emitted = emitted + drain(arrow_pixels(tile, x, y, x + x_vector, y + y_vector, stamp.offsets, stamp.count), sink);
+        }
+    }
+    TRACE_COUNTER("pixels", emitted);
+    TRACE_COUNTER("color evaluations", emitted);
+}
+
+// Tile t of the canvas, counting tiles_x per row from the bottom left.
+struct viewport tile_viewport(long t, long tiles_x)
+{
+    struct viewport tile;
+    tile.x_min = -(window_width / 2) + ((t % tiles_x) * TILE_SIZE);
+    tile.y_min = -(window_height / 2) + ((t / tiles_x) * TILE_SIZE);
+    tile.x_max = std::min(tile.x_min + TILE_SIZE, window_width - (window_width / 2)) - 1;
+    tile.y_max = std::min(tile.y_min + TILE_SIZE, window_height - (window_height / 2)) - 1;
+    return tile;
+}
+
+// Creates the PPM file at its full size, so that every tile can later seek to its rows, and returns the
+// size of its header, or -1 on error.
+long export_create(const char* filename)
+{
+    std::ostringstream header;
+    header << "P6\n" << window_width << " " << window_height << "\n255\n";
+    std::ofstream image(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    image << header.str();
+    image.seekp(header.str().size() + (3 * window_width * window_height) - 1);
+    image.put(0);
+    if (!image)
+    {
+        std::cerr << "ERROR: Could not create " << filename << ".\n";
+        return -1;
+    }
+    return header.str().size();
+}
+
+// Writes the rows of a finished tile into their place in the image. Rows of the image run from the top of
+// the canvas down.
+void export_write_tile(std::fstream& image, long header_size, const struct viewport& tile, const unsigned char* pixels)
+{
+    long tile_width = tile.x_max - tile.x_min + 1;
+    long tile_height = tile.y_max - tile.y_min + 1;
+    for (long r = 0; r < tile_height; r++)
+    {
+        long image_row = (window_height - 1) - (tile.y_max - r + (window_height / 2));
+        long image_column = tile.x_min + (window_width / 2);
+        image.seekp(header_size + (3 * ((image_row * window_width) + image_column)));
+        image.write((const char*)(pixels + (3 * r * tile_width)), 3 * tile_width);
+    }
+}
+
+// Clears the tile and renders it.
+void export_render_tile(const struct viewport& tile, unsigned char* pixels, const struct render_context& context)
+{
+    TRACE_ZONE("render tile");
+    long tile_width = tile.x_max - tile.x_min + 1;
+    long tile_height = tile.y_max - tile.y_min + 1;
+    std::fill(pixels, pixels + (3 * tile_width * tile_height), 0);
+    render_tile(tile, pixels, context);
+}
+
+// Basepoints and magnitude scale of the export. Both only depend on the seed and the canvas, so every
+// process of a render farm computes the same ones.
+void export_prepare(struct render_context& context, unsigned int seed)
+{
+    render_context_create(context, window_width, window_height, seed);
+    if (MAGNITUDE_MODE != MAGNITUDE_FIXED)
+    {
+        magnitude_max = magnitude_prepass();
+    }
+}
+
+// Headless export of the whole canvas as a binary PPM image, for canvases far larger than any window or
+// texture. The canvas is cut into TILE_SIZE x TILE_SIZE tiles that are rendered in parallel, and each
+// finished tile is written into its place in the file, so memory stays at one tile per worker however
+// large the canvas is.
+int export_tiled(const char* filename, unsigned int seed)
+{
+    struct render_context context;
+    export_prepare(context, seed);
+    long header_size = export_create(filename);
+    if (header_size < 0)
+    {
+        return 1;
+    }
+
+    long tiles_x = (window_width + TILE_SIZE - 1) / TILE_SIZE;
+    long tiles_y = (window_height + TILE_SIZE - 1) / TILE_SIZE;
+    std::atomic<bool> failed(false);
+    parallel_for_chunks(0, tiles_x * tiles_y, [&](long tile_begin, long tile_end, long /* worker */)
+    {
+        std::fstream image(filename, std::ios::in | std::ios::out | std::ios::binary);
+        std::vector<unsigned char> pixels(3 * TILE_SIZE * TILE_SIZE);
+        for (long t = tile_begin; t < tile_end; t++)
+        {
+            struct viewport tile = tile_viewport(t, tiles_x);
+            export_render_tile(tile, pixels.data(), context);
+            export_write_tile(image, header_size, tile, pixels.data());
+        }
+        image.flush();
+        if (!image)
+        {
+            failed = true;
+        }
+    });
+    if (failed)
+    {
+        std::cerr << "ERROR: Writing " << filename << " failed.\n";
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef __unix__
+// Render farm: the same export split across RENDER_FARM_WORKERS processes on this host. Each worker is this
+// program run again with --tile-worker, renders every RENDER_FARM_WORKERS-th tile (the expensive tiles
+// near the edges are spread out that way) and streams each finished tile over a pipe, as a tile_record
+// followed by its pixels. The coordinator assembles the tiles into the image as they arrive.
+struct tile_record
+{
+    long tile;
+    long bytes;
+};
+
+// Writes all of buffer to fd, across partial writes.
+bool write_all(int fd, const void* buffer, size_t size)
+{
+    const char* data = (const char*)buffer;
+    while (size > 0)
+    {
+        ssize_t written = write(fd, data, size);
+        if ((written < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data = data + written;
+        size = size - written;
+    }
+    return true;
+}
+
+// Worker side: renders tiles worker, worker + workers, ... of the canvas and writes them to standard output.
+int tile_worker(unsigned int seed, long worker, long workers)
+{
+    struct render_context context;
+    export_prepare(context, seed);
+    long tiles_x = (window_width + TILE_SIZE - 1) / TILE_SIZE;
+    long tiles_y = (window_height + TILE_SIZE - 1) / TILE_SIZE;
+    std::vector<unsigned char> pixels(3 * TILE_SIZE * TILE_SIZE);
+    for (long t = worker; t < tiles_x * tiles_y; t = t + workers)
+    {
+        struct viewport tile = tile_viewport(t, tiles_x);
+        export_render_tile(tile, pixels.data(), context);
+        struct tile_record record = { t, 3 * (tile.x_max - tile.x_min + 1) * (tile.y_max - tile.y_min + 1) };
+        if (!write_all(STDOUT_FILENO, &record, sizeof(record)) || !write_all(STDOUT_FILENO, pixels.data(), record.bytes))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Pipe of one worker and the tile it is currently sending.
+struct farm_worker
+{
+    pid_t pid;
+    int fd;
+    struct tile_record record;
+    size_t received;
+    std::vector<unsigned char> pixels;
+};
+
+// Coordinator side: starts the workers, assembles their tiles into the image and waits for all of them.
+int export_farm(const char* filename, unsigned int seed, long workers)
+{
+    long header_size = export_create(filename);
+    if (header_size < 0)
+    {
+        return 1;
+    }
+    std::fstream image(filename, std::ios::in | std::ios::out | std::ios::binary);
+    long tiles_x = (window_width + TILE_SIZE - 1) / TILE_SIZE;
+    long tiles_y = (window_height + TILE_SIZE - 1) / TILE_SIZE;
+
+    std::vector<struct farm_worker> farm;
+    for (long w = 0; w < workers; w++)
+    {
+        int channel[2];
+        if (pipe(channel) != 0)
+        {
+            std::cerr << "ERROR: Could not create a pipe for tile worker " << w << ".\n";
+            break;
+        }
+        std::string arguments[] = { std::to_string(seed), std::to_string(w), std::to_string(workers),
+            std::to_string(window_width), std::to_string(window_height) };
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            dup2(channel[1], STDOUT_FILENO);
+            close(channel[0]);
+            close(channel[1]);
+            execl("/proc/self/exe", "vector_field_line_color", "--tile-worker", arguments[0].c_str(), arguments[1].c_str(),
+                arguments[2].c_str(), arguments[3].c_str(), arguments[4].c_str(), (char*)NULL);
+            _exit(127);
+        }
+        close(channel[1]);
+        if (pid < 0)
+        {
+            std::cerr << "ERROR: Could not start tile worker " << w << ".\n";
+            close(channel[0]);
+            break;
+        }
+        struct farm_worker worker = { pid, channel[0], { 0, 0 }, 0, std::vector<unsigned char>() };
+        farm.push_back(worker);
+    }
+
+    // Read from whichever worker has data, so that no worker stalls on a full pipe.
+    long tiles_received = 0;
+    std::vector<struct pollfd> descriptors(farm.size());
+    long open_pipes = farm.size();
+    while (open_pipes > 0)
+    {
+        for (size_t w = 0; w < farm.size(); w++)
+        {
+            descriptors[w].fd = farm[w].fd;
+            descriptors[w].events = POLLIN;
+            descriptors[w].revents = 0;
+        }
+        if (poll(descriptors.data(), descriptors.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        for (size_t w = 0; w < farm.size(); w++)
+        {
+            if ((farm[w].fd < 0) || !(descriptors[w].revents & (POLLIN | POLLHUP | POLLERR)))
+            {
+                continue;
+            }
+            struct farm_worker& worker = farm[w];
+            bool header = worker.received < sizeof(struct tile_record);
+            char* target = header ? ((char*)&worker.record + worker.received) : (char*)(worker.pixels.data() + (worker.received - sizeof(struct tile_record)));
+            size_t wanted = header ? (sizeof(struct tile_record) - worker.received) : (sizeof(struct tile_record) + worker.record.bytes - worker.received);
+            ssize_t got = read(worker.fd, target, wanted);
+            if ((got < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            if (got <= 0)
+            {
+                close(worker.fd);
+                worker.fd = -1;
+                open_pipes = open_pipes - 1;
+                continue;
+            }
+            worker.received = worker.received + got;
+            if (header && (worker.received == sizeof(struct tile_record)))
+            {
+                worker.pixels.resize(worker.record.bytes);
+            }
+            if ((worker.received > sizeof(struct tile_record)) && (worker.received == sizeof(struct tile_record) + worker.record.bytes))
+            {
+                export_write_tile(image, header_size, tile_viewport(worker.record.tile, tiles_x), worker.pixels.data());
+                tiles_received = tiles_received + 1;
+                worker.received = 0;
+            }
+        }
+    }
+
+    bool failed = (long)farm.size() < workers;
+    for (size_t w = 0; w < farm.size(); w++)
+    {
+        int status;
+        waitpid(farm[w].pid, &status, 0);
+        failed = failed || !WIFEXITED(status) || (WEXITSTATUS(status) != 0);
+    }
+    image.flush();
+    if (failed || !image || (tiles_received != tiles_x * tiles_y))
+    {
+        std::cerr << "ERROR: Render farm delivered " << tiles_received << " of " << tiles_x * tiles_y << " tiles.\n";
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+// Runs the export with RENDER_FARM_WORKERS processes, or with threads in this process if that is 0.
+int export_image(const char* filename)
+{
+    if (MAGNITUDE_MODE == MAGNITUDE_FIXED)
+    {
+        std::cerr << "WARNING: MAGNITUDE_FIXED glyphs are unbounded, so every tile checks every cell.\n";
+        std::cerr << "Use MAGNITUDE_LINEAR or MAGNITUDE_LOG for large canvases.\n";
+    }
+
+    std::chrono::time_point<std::chrono::system_clock> start_time = std::chrono::system_clock::now();
+    unsigned int seed = hrng();
+    long tiles = ((window_width + TILE_SIZE - 1) / TILE_SIZE) * ((window_height + TILE_SIZE - 1) / TILE_SIZE);
+    int result;
+#ifdef __unix__
+    if (RENDER_FARM_WORKERS > 0)
+    {
+        result = export_farm(filename, seed, RENDER_FARM_WORKERS);
+    }
+    else
+#endif
+    {
+        result = export_tiled(filename, seed);
+    }
+    if (result != 0)
+    {
+        return result;
+    }
+
+    std::chrono::time_point<std::chrono::system_clock> end_time = std::chrono::system_clock::now();
+    std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    std::cout << "Exported " << window_width << " x " << window_height << " canvas in " << tiles <<
+        " tiles to " << filename << " in " << duration.count() << " milliseconds.\n";
+    return 0;
+}
+
+// Background recolor: every RECOLOR_SECONDS the field is shaded again with a new seed while the window stays
+// open, one of RECOLOR_BANDS bands of points at a time. The positions do not change, so each band is marked
+// as a dirty range and the event driven loop only draws its points again, over the cached image.
+struct recolor_state
+{
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stop = false;
+    // Recolored bands as (first point, r g b of every point), waiting for the main thread to upload them.
+    std::vector<std::pair<long, std::vector<float>>> bands;
+};
+
+// Runs on its own thread until recolor.stop is set. It only reads the positions in point_data, which nothing
+// writes once the field is computed; GL stays on the main thread.
+void recolor_worker(struct recolor_state& recolor, struct redraw_state& redraw, const float* point_data, long points)
+{
+    long band_points = (points + RECOLOR_BANDS - 1) / RECOLOR_BANDS;
+    std::unique_lock<std::mutex> guard(recolor.lock);
+    while (!recolor.wake.wait_for(guard, std::chrono::duration<double>(RECOLOR_SECONDS), [&recolor]() { return recolor.stop; }))
+    {
+        guard.unlock();
+        struct render_context context;
+        render_context_create(context, window_width, window_height, hrng());
+        for (long first = 0; first < points; first = first + band_points)
+        {
+            TRACE_ZONE("recolor");
+            long count = std::min(band_points, points - first);
+
+            // The colors are evaluated in pixel coordinates, and point_data is already normalized.
+            std::vector<float> positions(2 * count);
+            for (long i = 0; i < count; i++)
+            {
+                positions[2 * i] = std::round(point_data[5 * (first + i)] * (double)(window_width / 2));
+                positions[(2 * i) + 1] = std::round(point_data[(5 * (first + i)) + 1] * (double)(window_height / 2));
+            }
+            std::vector<float> colors(3 * count);
+            parallel_shade<2, 3>(positions.data(), colors.data(), count, [&context](const float* position, float* color)
+            {
+                render_shade_vertex(context, position, color);
+            });
+
+            {
+                std::lock_guard<std::mutex> band_guard(recolor.lock);
+                if (recolor.stop)
+                {
+                    return;
+                }
+                recolor.bands.push_back(std::make_pair(first, std::move(colors)));
+            }
+            redraw_mark_range(redraw, first, count);
+        }
+        guard.lock();
+    }
+}
+
+// Copies the bands recolored since the last call into point_data and into buffer, which holds point_data.
+void recolor_upload(struct recolor_state& recolor, unsigned int buffer, float* point_data)
+{
+    std::vector<std::pair<long, std::vector<float>>> bands;
+    {
+        std::lock_guard<std::mutex> guard(recolor.lock);
+        bands.swap(recolor.bands);
+    }
+    if (bands.empty())
+    {
+        return;
+    }
+    TRACE_ZONE("recolor upload");
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (size_t b = 0; b < bands.size(); b++)
+    {
+        long first = bands[b].first;
+        long count = bands[b].second.size() / 3;
+        for (long i = 0; i < count; i++)
+        {
+            point_data[(5 * (first + i)) + 2] = bands[b].second[3 * i];
+            point_data[(5 * (first + i)) + 3] = bands[b].second[(3 * i) + 1];
+            point_data[(5 * (first + i)) + 4] = bands[b].second[(3 * i) + 2];
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 5 * first * sizeof(float), 5 * count * sizeof(float), point_data + (5 * first));
+    }
+}
+
+int main(int argc, char** argv)
+{
+#ifdef __unix__
+    if ((argc == 7) && (std::string(argv[1]) == "--tile-worker"))
+    {
+        // Started by export_farm(): seed, worker index, worker count, canvas width and height.
+        window_width = std::atol(argv[5]);
+        window_height = std::atol(argv[6]);
+        return tile_worker(std::strtoul(argv[2], NULL, 10), std::atol(argv[3]), std::atol(argv[4]));
+    }
+#endif
+
+    // Get the boundaries of the window.
+    std::cout << "Enter Window Width: ";
+    std::cin >> window_width;
+    std::cout << "Enter Window Height: ";
+    std::cin >> window_height;
+
+    // The fixed glyph scale computes x^4 * y in long, which overflows on larger canvases.
+    if ((MAGNITUDE_MODE == MAGNITUDE_FIXED) && ((window_width > RENDER_FIELD_FIXED_MAX_SIDE) || (window_height > RENDER_FIELD_FIXED_MAX_SIDE)))
+    {
+        std::cerr << "ERROR: MAGNITUDE_FIXED supports canvas sides up to " << RENDER_FIELD_FIXED_MAX_SIDE << ". ";
+        std::cerr << "Use MAGNITUDE_LINEAR or MAGNITUDE_LOG for larger canvases. Exiting.\n";
+        return 1;
+    }
+
+    if (TILED_EXPORT)
+    {
+        // No window is needed, so the canvas is not limited to what GL can show.
+        int result = export_image(TILED_EXPORT_FILENAME);
+        if (MEMORY_REPORT)
+        {
+            memory_report(std::cout, "main");
+        }
+        TRACE_DUMP("vector_field_line_color.trace.json");
+        return result;
+    }
+
+    if (glfwInit() == GLFW_FALSE)
+    {
+        std::cerr << "ERROR: GLFW initialization failed. Exiting.";
+        return 1;
+    }
+
+    // Points go to point_data as interleaved (x, y, r, g, b) records, or to the separate position and color
+    // streams of store if SOA_VERTICES is set.
+    counted_vector<float, point_data_memory> point_data;
+    struct vertex_store store;
+    counted_vector<float, instance_data_memory> instance_data;
+    long points = 0;
+
+    // The field is computed on a worker thread while the window, the GL context and the shaders are set up
+    // below; GLFW itself has to stay on the main thread. Nothing in here may call GL.
+    std::future<void> field = std::async(std::launch::async, [&]()
+    {
+        struct render_context context;
+        render_context_create(context, window_width, window_height, hrng());
+
+        // With PERF_COUNTERS, the hardware counters of this thread and its workers are read around each kernel.
+        struct perf_counters perf;
+        if (PERF_COUNTERS)
+        {
+            perf_counters_open(perf);
+        }
+
+        std::chrono::time_point<std::chrono::system_clock> start_time = std::chrono::system_clock::now();
+        if (MAGNITUDE_MODE != MAGNITUDE_FIXED)
+        {
+            // With a bounded glyph length the worst case size of point_data is known up front.
+            magnitude_max = magnitude_prepass();
+            long cells = ((window_width + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR) * ((window_height + REDUCTION_FACTOR - 1) / REDUCTION_FACTOR);
+            std::cout << "Largest field magnitude: " << magnitude_max << ". At most " << cells * GLYPH_MAX_POINTS << " points.\n";
+        }
+        if (INSTANCED_ARROWS)
+        {
+            for (long i = -(window_width / 2); i < (window_width / 2); i = i + REDUCTION_FACTOR)
+            {
+                for (long j = -(window_height / 2); j < (window_height / 2); j = j + REDUCTION_FACTOR)
+                {
+                    point_plotter_function_instanced(instance_data, i, j);
+                }
+            }
+        }
+        else
+        {
+            // Every cell gets its exact slot in point_data from the plan, and the cells are split between the
+            // workers by pixel count rather than by position, so that the few long glyphs near the edges do not
+            // all land on one thread. Workers write to disjoint slices, so they need no locking.
+            counted_vector<struct cell_plan, cell_plan_memory> plan;
+            std::vector<long> offsets;
+            plan_grid(plan, offsets);
+            if (SOA_VERTICES)
+            {
+                vertex_store_resize(store, offsets.back());
+            }
+            else
+            {
+                point_data.resize(5 * offsets.back());
+            }
+            float* vertices = SOA_VERTICES ? store.positions.data() : point_data.data();
+            if (PERF_COUNTERS)
+            {
+                perf_counters_start(perf);
+            }
+            parallel_for_balanced(offsets, [&plan, &offsets, vertices](long cell_begin, long cell_end, long /* worker */)
+            {
+                TRACE_ZONE("rasterize");
+                for (long c = cell_begin; c < cell_end; c++)
+                {
+                    if (SOA_VERTICES)
+                    {
+                        render_cell<2>(vertices + (2 * offsets[c]), plan[c]);
+                    }
+                    else
+                    {
+                        render_cell<5>(vertices + (5 * offsets[c]), plan[c]);
+                    }
+                }
+            });
+            if (PERF_COUNTERS)
+            {
+                perf_counters_report(perf, "Bresenham loop", offsets.back(), std::cout);
+            }
+            TRACE_COUNTER("pixels", offsets.back());
+        }
+
+        // Shading pass: the geometry above only emitted positions, and every vertex or instance is colored
+        // here in parallel, independently of how its positions were produced.
+        auto shade = [&context](const float* position, float* color)
+        {
+            render_shade_vertex(context, position, color);
+        };
+        long shaded = (point_data.size() / 5) + vertex_store_count(store) + (instance_data.size() / INSTANCE_STRIDE);
+        if (PERF_COUNTERS)
+        {
+            perf_counters_start(perf);
+        }
+        parallel_shade<5, 5>(point_data.data(), point_data.data() + 2, point_data.size() / 5, shade);
+        parallel_shade<2, 3>(store.positions.data(), store.colors.data(), vertex_store_count(store), shade);
+        parallel_shade<INSTANCE_STRIDE, INSTANCE_STRIDE>(instance_data.data(), instance_data.data() + 2, instance_data.size() / INSTANCE_STRIDE, shade);
+        if (PERF_COUNTERS)
+        {
+            perf_counters_report(perf, "Color evaluation", shaded, std::cout);
+            perf_counters_start(perf);
+        }
+
+        {
+            TRACE_ZONE("normalize");
+            for (int i = 0; i < point_data.size(); i = i + 5)
+            {
+                point_data.at(i) = point_data.at(i) / (double)(window_width / 2);
+                point_data.at(i + 1) = point_data.at(i + 1) / (double)(window_height / 2);
+            }
+            vertex_store_scale(store, window_width / 2, window_height / 2);
+        }
+        if (PERF_COUNTERS)
+        {
+            perf_counters_report(perf, "Normalization pass", (point_data.size() / 5) + vertex_store_count(store), std::cout);
+            perf_counters_close(perf);
+        }
+        points = (point_data.size() / 5) + vertex_store_count(store);
+
+        std::chrono::time_point<std::chrono::system_clock> end_time = std::chrono::system_clock::now();
+        std::chrono::milliseconds duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+        std::cout << "Render Compute finished in " << duration.count() << " milliseconds.\n";
+        if (INSTANCED_ARROWS)
+        {
+            std::cout << "Arrow instances computed: " << instance_data.size() / INSTANCE_STRIDE << ".\n";
+        }
+        else
+        {
+            std::cout << "Points computed: " << points << ". Time per point: " <<
+                duration.count() / (float)points << " milliseconds.\n";
+        }
+    });
+
+    GLFWwindow* window = glfwCreateWindow(window_width, window_height, "Vector Field - Line Drawing", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cerr << "ERROR: GLFW failed to initialize drawing window. Exiting.";
+        glfwTerminate();
+        return 1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (glewInit() != GLEW_OK)
+    {
+        std::cerr << "ERROR: GLEW initialization failed. Exiting.";
+        glfwTerminate();
+        return 1;
+    }
+    std::cout << glGetString(GL_VERSION) << "\n";
+
+
+    // The shaders do not depend on the field, so they are compiled before waiting for it.
+    if (INSTANCED_ARROWS)
+    {
+        instanced_arrows_program(shaders_link_and_generate_program, window_width, window_height);
+    }
+    else
+    {
+        std::string vertex_shader_source = "#version 330 core\n\nlayout(location = 0) in vec4 position;\nlayout(location = 1) in vec4 color;\nout vec4 color_data;\nvoid main()\n{\n\tgl_Position = position;\n\tcolor_data = color;\n}";
+        std::string fragment_shader_source = "#version 330 core\n\nin vec4 color_data;\nout vec4 color;\nvoid main()\n{\n\tcolor = color_data;\n}";
+
+        unsigned int program_id = shaders_link_and_generate_program(vertex_shader_source, fragment_shader_source);
+        glUseProgram(program_id);
+    }
+
+    field.get();
+    // The field is field_count vertices, or field_count arrows when instanced. With every glyph clipped away
+    // there is nothing to upload or draw.
+    long field_count = INSTANCED_ARROWS ? (long)(instance_data.size() / INSTANCE_STRIDE) : (long)(points);
+
+    // Recoloring needs the event driven loop, which draws the dirty ranges, and the interleaved vertex buffer.
+    bool recolor_supported = EVENT_DRIVEN_REDRAW && !INSTANCED_ARROWS && !SOA_VERTICES;
+    if ((RECOLOR_SECONDS > 0) && !recolor_supported)
+    {
+        std::cerr << "WARNING: RECOLOR_SECONDS needs EVENT_DRIVEN_REDRAW and interleaved vertices. The colors stay fixed.\n";
+    }
+    bool recoloring = (RECOLOR_SECONDS > 0) && recolor_supported && (field_count > 0);
+    unsigned int buffer = 0;
+    if (field_count > 0)
+    {
+        TRACE_ZONE("upload");
+        if (INSTANCED_ARROWS)
+        {
+            upload_instanced_arrows(instance_data);
+        }
+        else if (SOA_VERTICES)
+        {
+            // Positions and colors live in separate buffers.
+            unsigned int buffers[2];
+            vertex_store_upload(store, buffers);
+        }
+        else
+        {
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, point_data.size() * sizeof(float), point_data.data(), recoloring ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+            memory_gl_allocated(MEMORY_STAGE_GL_BUFFERS, point_data.size() * sizeof(float));
+
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, 0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (const void*)(sizeof(float) * 2));
+        }
+    }
+
+    // Draws count vertices, or count arrows when instanced, starting at first. Every present that draws
+    // points first takes in the recolored bands, whose ranges are then drawn by this or the next present.
+    struct recolor_state recolor;
+    auto draw_field = [&](long first, long count)
+    {
+        TRACE_ZONE("draw");
+        if (recoloring)
+        {
+            recolor_upload(recolor, buffer, point_data.data());
+        }
+        if (count == 0)
+        {
+            return;
+        }
+        if (INSTANCED_ARROWS)
+        {
+            // GL 3.3 has no base instance, so a range of arrows redraws all of them.
+            glDrawArraysInstanced(GL_LINES, 0, ARROW_MESH_VERTICES, field_count);
+        }
+        else
+        {
+            glDrawArrays(GL_POINTS, first, count);
+        }
+    };
+
+    // The toggles of the window loop are described in RenderLoop.h. The recolor thread marks its bands in
+    // redraw, which wakes the loop up.
+    struct redraw_state redraw;
+    std::thread recolor_thread;
+    if (recoloring)
+    {
+        recolor_thread = std::thread(recolor_worker, std::ref(recolor), std::ref(redraw), (const float*)point_data.data(), field_count);
+    }
+    struct render_loop_options options = { STATIC_PLOT, EVENT_DRIVEN_REDRAW, FRAME_STATS, FRAME_STATS_OVERLAY, &redraw };
+    render_loop(window, field_count, draw_field, options);
+    if (recoloring)
+    {
+        {
+            std::lock_guard<std::mutex> guard(recolor.lock);
+            recolor.stop = true;
+        }
+        recolor.wake.notify_one();
+        recolor_thread.join();
+    }
+
+    if (MEMORY_REPORT)
+    {
+        memory_report(std::cout, "main");
+    }
+    TRACE_DUMP("vector_field_line_color.trace.json");
+    glfwTerminate();
+    return 0;
 }
\ No newline at end of file